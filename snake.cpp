@@ -1,14 +1,29 @@
 #include <iostream>
-#include <deque>
 #include <cstdlib>
-#include <ctime>
 #include <chrono>
 #include <thread>
 #include <algorithm>
 #include <memory>
 #include <cstdio>
-#include <sstream>
 #include <string>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "snake_arena.h"
+#include "snake_batch.h"
+#include "snake_bot.h"
+#include "snake_engine.h"
+#include "snake_policy.h"
+#include "snake_recording.h"
+#include "snake_render.h"
+#include "snake_rewind.h"
+#include "snake_server.h"
+#include "snake_stats.h"
+#include "snake_terminal.h"
 
 #ifndef _WIN32
     #include <sys/ioctl.h>
@@ -22,56 +37,50 @@
     #include <unistd.h>
     #include <termios.h>
     #include <fcntl.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
 #endif
 
-// ANSI Color Codes
-const std::string RESET = "\033[0m";
-const std::string RED = "\033[31m";
-const std::string GREEN = "\033[32m";
-const std::string YELLOW = "\033[33m";
-const std::string BLUE = "\033[34m";
-const std::string MAGENTA = "\033[35m";
-const std::string CYAN = "\033[36m";
-const std::string WHITE = "\033[37m";
-const std::string BOLD = "\033[1m";
-const std::string BG_RED = "\033[41m";
-const std::string BG_GREEN = "\033[42m";
-const std::string BG_YELLOW = "\033[43m";
-
-// Game Constants
-const int INITIAL_SPEED = 150; // milliseconds per frame
-const int SPEED_INCREMENT = 5; // speed increase per food eaten
-const int DEFAULT_WIDTH = 40;
-const int DEFAULT_HEIGHT = 20;
-const int MIN_WIDTH = 12;
-const int MIN_HEIGHT = 8;
-
-// Point structure for coordinates
-struct Point {
-    int x, y;
-
-    bool operator==(const Point& other) const {
-        return x == other.x && y == other.y;
-    }
-
-    bool operator!=(const Point& other) const {
-        return !(*this == other);
-    }
-};
+// Frame timing constants
+const int MAX_CATCH_UP_TICKS = 5; // ticks simulated back-to-back before giving up on lost time
+const int STATS_HUD_REFRESH_MS = 500; // how often the HUD timing summary is updated
 
-// Direction enum
-enum Direction {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT,
-    NONE
-};
+// Autopilot constants
+const int AUTOPILOT_BUDGET_MICROS = 500; // planning time allowed per tick when playing live
+
+// Replay constants
+const int MAX_REPLAY_SPEED = 64;        // fast-forward steps through 1x, 4x, 16x and 64x
+const int REPLAY_SEEK_STEPS = 20;       // [ and ] jump this fraction of the game...
+const int REPLAY_SEEK_MIN_TICKS = 100;  // ...but at least this many ticks
+const size_t TICK_STATS_FLUSH_BYTES = 1 << 20; // --tick-stats output buffered per write
+
+// Bot interface constants
+const int BOT_REPLY_TIMEOUT_MS = 1000;  // lock-step: longest wait for a bot's move
+const int BOT_ATTACH_TIMEOUT_MS = 60000; // headless: wait this long for the first move
+
+#ifndef _WIN32
+// Self-pipe for SIGWINCH: the handler writes a byte to the write end and
+// KeyboardInput polls the read end alongside stdin, so a resize wakes the
+// game however long it was going to wait. -1 while no KeyboardInput exists.
+volatile sig_atomic_t resizeWriteFd = -1;
+
+void onTerminalResize(int) {
+    int savedErrno = errno;
+    if (resizeWriteFd >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(resizeWriteFd, &byte, 1);  // Full pipe: a wake is pending anyway
+        (void)ignored;
+    }
+    errno = savedErrno;
+}
+#endif
 
 // Cross-platform keyboard input handling
 class KeyboardInput {
 public:
-    KeyboardInput() {
+    KeyboardInput() : head(0), count(0), inputClosed(false) {
         #ifndef _WIN32
         tcflush(STDIN_FILENO, TCIFLUSH);
         tcgetattr(STDIN_FILENO, &oldt);
@@ -79,130 +88,484 @@ public:
         newt.c_lflag &= ~(ICANON | ECHO);
         tcsetattr(STDIN_FILENO, TCSANOW, &newt);
         fcntl(STDIN_FILENO, F_SETFL, O_NONBLOCK);
+
+        if (pipe(resizePipe) == 0) {
+            for (int i = 0; i < 2; ++i) {
+                fcntl(resizePipe[i], F_SETFL, O_NONBLOCK);
+                fcntl(resizePipe[i], F_SETFD, FD_CLOEXEC);
+            }
+            resizeWriteFd = resizePipe[1];
+        } else {
+            resizePipe[0] = resizePipe[1] = -1;
+        }
+
+        // SA_RESTART keeps the signal from failing reads and writes; the
+        // pipe is what wakes waitForInput()
+        struct sigaction resize;
+        memset(&resize, 0, sizeof(resize));
+        resize.sa_handler = onTerminalResize;
+        sigemptyset(&resize.sa_mask);
+        resize.sa_flags = SA_RESTART;
+        sigaction(SIGWINCH, &resize, &oldResize);
         #endif
     }
 
     ~KeyboardInput() {
         #ifndef _WIN32
+        sigaction(SIGWINCH, &oldResize, nullptr);
+        resizeWriteFd = -1;
+        if (resizePipe[0] >= 0) {
+            ::close(resizePipe[0]);
+            ::close(resizePipe[1]);
+        }
         tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
         fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) & ~O_NONBLOCK);
         #endif
     }
 
-    bool kbhit() {
+    // True once for each burst of terminal resizes since the last call
+    bool takeResize() {
         #ifdef _WIN32
-        return _kbhit();
+        return false;
         #else
-        struct timeval tv = {0, 0};
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(STDIN_FILENO, &fds);
-        return select(STDIN_FILENO + 1, &fds, nullptr, nullptr, &tv) > 0;
+        char drained[64];
+        bool resized = false;
+        while (resizePipe[0] >= 0 && read(resizePipe[0], drained, sizeof(drained)) > 0) {
+            resized = true;
+        }
+        return resized;
         #endif
     }
 
-    char getch() {
+    // stdin reached end of file, so no key will ever arrive
+    bool closed() const { return inputClosed; }
+
+    // Block until a key is buffered, the terminal is resized or timeoutMs
+    // elapses (-1 waits forever); true only if a key may be ready
+    bool waitForInput(int timeoutMs) {
+        if (count > 0) return true;
+        if (inputClosed) {
+            // Nothing will ever arrive; just honour the timeout
+            if (timeoutMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return false;
+        }
         #ifdef _WIN32
-        return _getch();
+        DWORD wait = timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs);
+        // Console handles also signal for focus/mouse events; callers re-check
+        return WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), wait) == WAIT_OBJECT_0;
         #else
-        char c;
-        return read(STDIN_FILENO, &c, 1) > 0 ? c : 0;
+        struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {resizePipe[0], POLLIN, 0}};
+        return poll(fds, 2, timeoutMs) > 0 && fds[0].revents != 0;
         #endif
     }
 
+    // Next complete key press, decoded by KeyDecoder
+    bool nextKey(char& key) {
+        fill();
+        while (count > 0) {
+            char c = buffer[head];
+            head = (head + 1) % INPUT_BUFFER_SIZE;
+            count--;
+
+            if (decoder.feed(c, key)) return true;
+        }
+        return false;
+    }
+
+    // Discard everything typed so far, including half-parsed sequences
+    void flush() {
+        #ifdef _WIN32
+        while (_kbhit()) {
+            _getch();
+        }
+        #else
+        tcflush(STDIN_FILENO, TCIFLUSH);
+        char discard[INPUT_BUFFER_SIZE];
+        while (read(STDIN_FILENO, discard, sizeof(discard)) > 0) {
+        }
+        #endif
+        head = 0;
+        count = 0;
+        decoder.reset();
+    }
+
 private:
+    static const int INPUT_BUFFER_SIZE = 256;
+    char buffer[INPUT_BUFFER_SIZE];  // Ring buffer of raw bytes
+    int head;
+    int count;
+    KeyDecoder decoder;
+    bool inputClosed;                // stdin hit EOF; stop polling it
+
     #ifndef _WIN32
     struct termios oldt, newt;
+    struct sigaction oldResize;
+    int resizePipe[2];               // Read end polled by waitForInput()
     #endif
+
+    // Move everything the terminal has ready into the ring buffer
+    void fill() {
+        while (count < INPUT_BUFFER_SIZE) {
+            int tail = (head + count) % INPUT_BUFFER_SIZE;
+            #ifdef _WIN32
+            if (!_kbhit()) break;
+            buffer[tail] = static_cast<char>(_getch());
+            count++;
+            #else
+            // Read straight into the free contiguous span in one syscall
+            int span = (tail >= head) ? INPUT_BUFFER_SIZE - tail : head - tail;
+            ssize_t got = read(STDIN_FILENO, buffer + tail, span);
+            if (got == 0) inputClosed = true;
+            if (got <= 0) break;
+            count += static_cast<int>(got);
+            #endif
+        }
+    }
 };
 
-// Snake Game Class
-class SnakeGame {
-private:
-    std::deque<Point> snake;
-    Point food;
-    Direction direction;
-    Direction nextDirection;
-    bool gameOver;
-    bool paused;
-    int score;
-    int speed;
-    std::unique_ptr<KeyboardInput> keyboard;
-    int boardWidth;
-    int boardHeight;
-    int terminalWidth;
-    int terminalHeight;
-    bool sizeWarning;
-    std::string sizeWarningMessage;
+// Read-only view of a whole file, mapped rather than read so that only the
+// pages actually used are loaded (a seek in a long recording touches a few)
+class MappedFile {
+public:
+    MappedFile()
+        : bytes(nullptr),
+          length(0)
+          #ifdef _WIN32
+          , fileHandle(NULL),
+          mapping(NULL)
+          #endif
+    {
+    }
 
-    void spawnFood() {
-        bool validPosition;
-        if (static_cast<int>(snake.size()) >= boardWidth * boardHeight) {
-            gameOver = true;
-            return;
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+        #ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return false;
         }
-        do {
-            validPosition = true;
-            food.x = rand() % boardWidth;
-            food.y = rand() % boardHeight;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart <= 0) {
+            CloseHandle(handle);
+            return false;
+        }
+        HANDLE view = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* base = view ? MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!base) {
+            if (view) CloseHandle(view);
+            CloseHandle(handle);
+            return false;
+        }
+        fileHandle = handle;
+        mapping = view;
+        length = static_cast<size_t>(fileSize.QuadPart);
+        #else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* base = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        #endif
+        bytes = static_cast<const unsigned char*>(base);
+        return true;
+    }
 
-            // Make sure food doesn't spawn on snake
-            for (const auto& segment : snake) {
-                if (segment == food) {
-                    validPosition = false;
-                    break;
-                }
-            }
-        } while (!validPosition);
+    void close() {
+        if (!bytes) return;
+        #ifdef _WIN32
+        UnmapViewOfFile(bytes);
+        CloseHandle(mapping);
+        CloseHandle(fileHandle);
+        mapping = NULL;
+        fileHandle = NULL;
+        #else
+        munmap(const_cast<unsigned char*>(bytes), length);
+        #endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes;
+    size_t length;
+    #ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mapping;
+    #endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// Fixed-rate tick scheduling against steady_clock deadlines. Each deadline
+// is one period after the previous one, not after the previous frame's
+// work, so render time does not stretch ticks. When the loop falls behind,
+// the caller simulates ticks back-to-back and skips rendering to catch up.
+class TickScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    TickScheduler()
+        : ticks(0),
+          lateTicks(0),
+          resyncs(0),
+          worstLag(Clock::duration::zero()) {
+    }
+
+    // Schedule the first tick one period from now
+    void start(int periodMs) {
+        deadline = Clock::now() + std::chrono::milliseconds(periodMs);
+    }
+
+    // Whole milliseconds left until the current tick is due, rounded up so
+    // a wait of this length never wakes early
+    int millisUntilDeadline() const {
+        Clock::duration left = deadline - Clock::now();
+        if (left <= Clock::duration::zero()) return 0;
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            left + std::chrono::milliseconds(1) - Clock::duration(1)).count());
+    }
+
+    // Called once the tick is due; records how late it started
+    void beginTick() {
+        Clock::duration lag = Clock::now() - deadline;
+        if (lag > worstLag) worstLag = lag;
     }
 
-    void moveSnake() {
-        // Update direction (prevent 180-degree turns)
-        if ((direction == UP && nextDirection != DOWN) ||
-            (direction == DOWN && nextDirection != UP) ||
-            (direction == LEFT && nextDirection != RIGHT) ||
-            (direction == RIGHT && nextDirection != LEFT)) {
-            direction = nextDirection;
+    // Schedule the next tick `periodMs` after the current deadline. Returns
+    // false when that deadline has already passed, meaning there is no time
+    // left to render this frame.
+    bool advance(int periodMs) {
+        std::chrono::milliseconds period(periodMs);
+        deadline += period;
+        ticks++;
+
+        Clock::time_point now = Clock::now();
+        if (now < deadline) {
+            return true;
         }
 
-        // Calculate new head position
-        Point newHead = snake.front();
-        switch (direction) {
-            case UP:    newHead.y--; break;
-            case DOWN:  newHead.y++; break;
-            case LEFT:  newHead.x--; break;
-            case RIGHT: newHead.x++; break;
-            case NONE:  return;
+        lateTicks++;
+        if (now - deadline > period * MAX_CATCH_UP_TICKS) {
+            // Too far behind (e.g. the process was stopped); drop the lost
+            // time instead of fast-forwarding through it
+            deadline = now;
+            resyncs++;
         }
+        return false;
+    }
 
-        // Check wall collision
-        if (newHead.x < 0 || newHead.x >= boardWidth ||
-            newHead.y < 0 || newHead.y >= boardHeight) {
-            gameOver = true;
-            return;
+    long long tickCount() const { return ticks; }
+    long long lateTickCount() const { return lateTicks; }
+    long long resyncCount() const { return resyncs; }
+    double worstLagMs() const {
+        return std::chrono::duration<double, std::milli>(worstLag).count();
+    }
+
+private:
+    Clock::time_point deadline;
+    long long ticks;
+    long long lateTicks;   // Ticks that finished after the next deadline (frame skipped)
+    long long resyncs;     // Times the schedule was reset after falling too far behind
+    Clock::duration worstLag;
+};
+
+// Writes frames to the terminal on its own thread so a slow terminal (e.g.
+// over SSH) stalls only the writer, never the simulation. There is a single
+// slot: the game thread fills it only while the writer is idle, and while a
+// write is in flight the game thread skips composing frames altogether. The
+// renderer then still holds the last frame sent, so the next composed frame
+// carries every change made in between and nothing is lost by dropping.
+class FrameWriter {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameWriter()
+        : busy(false),
+          stopping(false),
+          writes(0),
+          seenWrites(0),
+          lastWrite(Clock::duration::zero()) {
+    }
+
+    ~FrameWriter() {
+        stop();
+    }
+
+    void start() {
+        if (thread.joinable()) return;
+        stopping = false;
+        thread = std::thread(&FrameWriter::loop, this);
+    }
+
+    // Finish the frame being written, then end the thread
+    void stop() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
         }
+        wake.notify_one();
+        thread.join();
+    }
 
-        // Check self collision
-        for (const auto& segment : snake) {
-            if (segment == newHead) {
-                gameOver = true;
-                return;
-            }
+    // True when a new frame can be submitted without waiting
+    bool idle() const {
+        return !busy.load(std::memory_order_acquire);
+    }
+
+    // Hand a frame to the writer. Only call while idle(); `frame` receives
+    // the previously written buffer so its storage is reused.
+    void submit(std::string& frame) {
+        slot.swap(frame);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy.store(true, std::memory_order_release);
         }
+        wake.notify_one();
+    }
+
+    // Block until the pending frame is on the terminal, before other output
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return !busy.load(std::memory_order_acquire); });
+    }
 
-        // Add new head
-        snake.push_front(newHead);
+    // Duration of the last completed write, if one finished since the last call
+    bool takeWriteTime(Clock::duration& elapsed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (writes == seenWrites) return false;
+        seenWrites = writes;
+        elapsed = lastWrite;
+        return true;
+    }
 
-        // Check if food is eaten
-        if (newHead == food) {
-            score++;
-            speed = std::max(50, INITIAL_SPEED - (score * SPEED_INCREMENT));
-            spawnFood();
-        } else {
-            // Remove tail if no food eaten
-            snake.pop_back();
+private:
+    std::thread thread;
+    std::atomic<bool> busy;  // `slot` holds a frame not yet fully written
+    std::string slot;
+    std::mutex mutex;        // Guards sleeping and waking, not the slot itself
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping;
+    long long writes;
+    long long seenWrites;
+    Clock::duration lastWrite;
+
+    void loop() {
+        #ifndef _WIN32
+        // Leave resize signals to the game thread, whose poll() they wake
+        sigset_t blocked;
+        sigemptyset(&blocked);
+        sigaddset(&blocked, SIGWINCH);
+        pthread_sigmask(SIG_BLOCK, &blocked, nullptr);
+        #endif
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return busy.load(std::memory_order_acquire) || stopping; });
+                if (!busy.load(std::memory_order_acquire)) return;
+            }
+
+            Clock::time_point start = Clock::now();
+            writeAll(slot);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                lastWrite = Clock::now() - start;
+                writes++;
+                busy.store(false, std::memory_order_release);
+            }
+            done.notify_all();
+        }
+    }
+
+    // Write the whole buffer to the terminal, retrying on short writes
+    static void writeAll(const std::string& buffer) {
+        #ifdef _WIN32
+        fwrite(buffer.data(), 1, buffer.size(), stdout);
+        fflush(stdout);
+        #else
+        const char* data = buffer.data();
+        size_t remaining = buffer.size();
+        while (remaining > 0) {
+            ssize_t written = write(STDOUT_FILENO, data, remaining);
+            if (written > 0) {
+                data += written;
+                remaining -= static_cast<size_t>(written);
+            } else if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written < 0 && errno == EAGAIN) {
+                // stdout shares the tty with stdin, which KeyboardInput made non-blocking
+                struct pollfd pfd = {STDOUT_FILENO, POLLOUT, 0};
+                poll(&pfd, 1, -1);
+            } else {
+                break;
+            }
         }
+        #endif
     }
+};
+
+// What the player picked on the game over screen
+enum GameOverChoice {
+    CHOICE_QUIT,
+    CHOICE_RESTART,
+    CHOICE_REWIND
+};
+
+// Snake Game Class
+class SnakeGame {
+private:
+    SnakeEngine engine;
+    Direction nextDirection;
+    bool gameOver;                       // Engine reported game over or player quit
+    bool paused;
+    std::unique_ptr<KeyboardInput> keyboard;
+    InputRecorder recorder;
+    MappedFile replayFile;               // Recording `replay` reads from
+    InputReplay replay;
+    TickScheduler scheduler;
+    TurnQueue turns;
+    bool replaying;                      // Inputs come from `replay`, not the keyboard
+    int replaySpeed;                     // Recorded ticks played per tick
+    long long replayStart;               // Tick the first replayed game starts from
+    std::unique_ptr<SnakePolicy> autopilot; // Steers instead of the keyboard when set
+    std::unique_ptr<BotLink> bot;        // External bot; steers instead of the autopilot
+    RewindBuffer rewindBuffer;
+    bool fixedSeed;
+    uint64_t seedValue;
+    int boardWidth;
+    int boardHeight;
+    int worldWidth;                      // Scrolling world size, 0 to fit the terminal
+    int worldHeight;
+    int terminalWidth;
+    int terminalHeight;
+    bool sizeWarning;
+    std::string sizeWarningMessage;
+    FrameRenderer renderer;
+    FrameWriter writer;
+    std::string outgoing;                // Spare frame buffer swapped with the writer's
+    FrameStats stats;
+    bool statsHud;                       // Show frame timings on the HUD line
+    FrameStats::Clock::time_point hudRefreshed;
 
     void clearScreen() {
         #ifdef _WIN32
@@ -213,15 +576,16 @@ private:
         #endif
     }
 
-    void updateBoardDimensions() {
+    // Read the terminal size and fit the viewport to it
+    BoardFit fitViewport() {
         #ifdef _WIN32
         CONSOLE_SCREEN_BUFFER_INFO csbi;
         if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
             terminalWidth = csbi.srWindow.Right - csbi.srWindow.Left + 1;
             terminalHeight = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
         } else {
-            terminalWidth = DEFAULT_WIDTH + 4;
-            terminalHeight = DEFAULT_HEIGHT + 8;
+            terminalWidth = FALLBACK_COLUMNS;
+            terminalHeight = FALLBACK_ROWS;
         }
         #else
         struct winsize ws{};
@@ -229,61 +593,31 @@ private:
             terminalWidth = ws.ws_col;
             terminalHeight = ws.ws_row;
         } else {
-            terminalWidth = DEFAULT_WIDTH + 4;
-            terminalHeight = DEFAULT_HEIGHT + 8;
+            terminalWidth = FALLBACK_COLUMNS;
+            terminalHeight = FALLBACK_ROWS;
         }
         #endif
 
-        const int horizontalPadding = 4;  // Two leading spaces plus side walls
-        // Title(3) + Score(1) + Warning(1) + TopBorder(1) + BottomBorder(1) + Controls(1) = 9 lines
-        const int verticalPadding = 9;
-
-        int availableWidth = (terminalWidth > 0) ? terminalWidth - horizontalPadding : DEFAULT_WIDTH;
-        int availableHeight = (terminalHeight > 0) ? terminalHeight - verticalPadding : DEFAULT_HEIGHT;
-
-        if (availableWidth <= 0) availableWidth = DEFAULT_WIDTH;
-        if (availableHeight <= 0) availableHeight = DEFAULT_HEIGHT;
-
-        int newBoardWidth = std::min(DEFAULT_WIDTH, availableWidth);
-        int newBoardHeight = std::min(DEFAULT_HEIGHT, availableHeight);
-
-        if (availableWidth < 5) {
-            newBoardWidth = std::max(availableWidth, 1);
-        } else if (newBoardWidth < MIN_WIDTH && availableWidth >= MIN_WIDTH) {
-            newBoardWidth = MIN_WIDTH;
-        }
+        BoardFit fit = fitBoard(terminalWidth, terminalHeight);
+        renderer.setViewport(fit.viewWidth, fit.viewHeight);
+        return fit;
+    }
 
-        if (availableHeight < 5) {
-            newBoardHeight = std::max(availableHeight, 1);
-        } else if (newBoardHeight < MIN_HEIGHT && availableHeight >= MIN_HEIGHT) {
-            newBoardHeight = MIN_HEIGHT;
+    // Size the next game's board from the terminal, unless --world set it
+    void updateBoardDimensions() {
+        BoardFit fit = fitViewport();
+        if (worldWidth > 0) {
+            boardWidth = worldWidth;
+            boardHeight = worldHeight;
+            sizeWarning = false;
+            sizeWarningMessage.clear();
+            return;
         }
 
-        newBoardWidth = std::max(newBoardWidth, 1);
-        newBoardHeight = std::max(newBoardHeight, 1);
-
-        bool widthTrimmed = newBoardWidth < DEFAULT_WIDTH;
-        bool heightTrimmed = newBoardHeight < DEFAULT_HEIGHT;
-
-        boardWidth = newBoardWidth;
-        boardHeight = newBoardHeight;
-
-        sizeWarning = widthTrimmed || heightTrimmed;
-        sizeWarningMessage.clear();
-
-        if (sizeWarning) {
-            std::ostringstream warn;
-            warn << "Arena scaled to " << boardWidth << "x" << boardHeight
-                 << " (ideal " << DEFAULT_WIDTH << "x" << DEFAULT_HEIGHT << ")";
-            sizeWarningMessage = warn.str();
-
-            int maxHudWidth = boardWidth + 4;
-            if (static_cast<int>(sizeWarningMessage.size()) > maxHudWidth) {
-                std::ostringstream shortWarn;
-                shortWarn << "Arena " << boardWidth << "x" << boardHeight;
-                sizeWarningMessage = shortWarn.str();
-            }
-        }
+        boardWidth = fit.width;
+        boardHeight = fit.height;
+        sizeWarning = !fit.warning.empty();
+        sizeWarningMessage = fit.warning;
     }
 
     void initTerminal() {
@@ -304,150 +638,84 @@ private:
     }
 
     void render() {
-        // Just home cursor - we're in alternate buffer so no scrolling
-        printf("\033[H");
-        
-        // Title
-        printf("\033[1m\033[36m╔");
-        for (int i = 0; i < boardWidth + 2; ++i) printf("═");
-        printf("╗\n");
-
-        printf("║");
-        int titlePad = (boardWidth + 2 - 16) / 2;  // 16 = length of "C++ SNAKE GAME"
-        for (int i = 0; i < titlePad; ++i) printf(" ");
-        printf("\033[33mC++ SNAKE GAME\033[36m");
-        for (int i = 0; i < boardWidth + 2 - 16 - titlePad; ++i) printf(" ");
-        printf("║\n");
-
-        printf("╚");
-        for (int i = 0; i < boardWidth + 2; ++i) printf("═");
-        printf("╝\033[0m\n");
-
-        // HUD
-        int displaySpeed = std::max(0, INITIAL_SPEED - speed + 50);
-        printf("  \033[32mScore: \033[1m%d\033[0m  \033[35mSpeed: \033[1m%d\033[0m\n", score, displaySpeed);
-
-        if (sizeWarning && !sizeWarningMessage.empty()) {
-            printf("  \033[33m%s\033[0m\n", sizeWarningMessage.c_str());
-        }
-
-        // Top border
-        printf("  \033[36m┌");
-        for (int i = 0; i < boardWidth; ++i) printf("─");
-        printf("┐\033[0m\n");
-
-        // Game board
-        for (int y = 0; y < boardHeight; ++y) {
-            printf("  \033[36m│\033[0m");
-
-            for (int x = 0; x < boardWidth; ++x) {
-                bool drawn = false;
-
-                if (x == food.x && y == food.y) {
-                    printf("\033[31m●\033[0m");
-                    drawn = true;
-                } else if (!snake.empty() && x == snake.front().x && y == snake.front().y) {
-                    printf("\033[32m\033[1m◆\033[0m");
-                    drawn = true;
-                } else if (!snake.empty()) {
-                    for (size_t i = 1; i < snake.size() && !drawn; ++i) {
-                        if (x == snake[i].x && y == snake[i].y) {
-                            printf("\033[32m■\033[0m");
-                            drawn = true;
-                        }
-                    }
-                }
-
-                if (!drawn) {
-                    printf(" ");
-                }
-            }
-
-            printf("\033[36m│\033[0m\n");
+        FrameStats::Clock::duration written;
+        if (writer.takeWriteTime(written)) {
+            stats.record(PHASE_WRITE, written);
+        }
+        if (!writer.idle()) {
+            // The terminal is still taking the last frame; skip this one
+            stats.recordDroppedFrame();
+            return;
         }
 
-        // Bottom border
-        printf("  \033[36m└");
-        for (int i = 0; i < boardWidth; ++i) printf("─");
-        printf("┘\033[0m\n");
+        FrameStats::Clock::time_point start = FrameStats::Clock::now();
+        if (statsHud && start - hudRefreshed >= std::chrono::milliseconds(STATS_HUD_REFRESH_MS)) {
+            renderer.setHudStatus(stats.takeHudSummary());
+            hudRefreshed = start;
+        } else if (replaying && !statsHud) {
+            std::string status;
+            replayStatus(status);
+            renderer.setHudStatus(status);
+        }
 
-        // Controls
-        if (paused) {
-            printf("  \033[33m\033[1m⏸  PAUSED - Press SPACE to resume\033[0m");
-        } else {
-            printf("  \033[37mControls: WASD or Arrow Keys | SPACE to pause | Q to quit\033[0m");
+        bool changed = renderer.compose(engine, paused);
+        FrameStats::Clock::time_point composed = FrameStats::Clock::now();
+        stats.record(PHASE_COMPOSE, composed - start);
+        if (changed) {
+            fflush(stdout);  // Keep ordering with any pending printf output
+            renderer.takeFrame(outgoing);
+            stats.recordFrameBytes(outgoing.size());
+            writer.submit(outgoing);
         }
+    }
 
-        printf("\033[J");  // Clear to end of screen
-        fflush(stdout);
+    // Queue a turn to apply on a later tick (see TurnQueue)
+    void queueDirection(Direction d) {
+        if (replaying || autopilot || bot) return;
+        turns.push(d, engine.direction());
     }
 
+    // Handle every key that has arrived since the last call
     void processInput() {
         if (!keyboard) return;
-        if (keyboard->kbhit()) {
-            char key = keyboard->getch();
-
-            // Handle arrow keys (escape sequences on Unix)
-            #ifndef _WIN32
-            if (key == 27) { // ESC
-                if (keyboard->kbhit() && keyboard->getch() == '[') {
-                    if (keyboard->kbhit()) {
-                        key = keyboard->getch();
-                        switch (key) {
-                            case 'A': key = 'w'; break; // Up arrow
-                            case 'B': key = 's'; break; // Down arrow
-                            case 'C': key = 'd'; break; // Right arrow
-                            case 'D': key = 'a'; break; // Left arrow
-                        }
-                    }
-                }
-            }
-            #else
-            // Windows arrow keys
-            if (key == -32 || key == 0) {
-                key = keyboard->getch();
-                switch (key) {
-                    case 72: key = 'w'; break; // Up arrow
-                    case 80: key = 's'; break; // Down arrow
-                    case 77: key = 'd'; break; // Right arrow
-                    case 75: key = 'a'; break; // Left arrow
-                }
-            }
-            #endif
-
-            // Process key
+        char key;
+        while (!gameOver && keyboard->nextKey(key)) {
             switch (key) {
                 case 'w':
                 case 'W':
-                    if (direction == NONE || direction != DOWN) {
-                        nextDirection = UP;
-                        if (direction == NONE) direction = UP;
-                    }
+                    queueDirection(UP);
                     break;
                 case 's':
                 case 'S':
-                    if (direction == NONE || direction != UP) {
-                        nextDirection = DOWN;
-                        if (direction == NONE) direction = DOWN;
-                    }
+                    queueDirection(DOWN);
                     break;
                 case 'a':
                 case 'A':
-                    if (direction == NONE || direction != RIGHT) {
-                        nextDirection = LEFT;
-                        if (direction == NONE) direction = LEFT;
-                    }
+                    queueDirection(LEFT);
                     break;
                 case 'd':
                 case 'D':
-                    if (direction == NONE || direction != LEFT) {
-                        nextDirection = RIGHT;
-                        if (direction == NONE) direction = RIGHT;
-                    }
+                    queueDirection(RIGHT);
                     break;
                 case ' ':
                     paused = !paused;
                     break;
+                case 'b':
+                case 'B':
+                    rewind();
+                    break;
+                case 'f':
+                case 'F':
+                    if (replaying) {
+                        replaySpeed = replaySpeed >= MAX_REPLAY_SPEED ? 1 : replaySpeed * 4;
+                    }
+                    break;
+                case '[':
+                    seekReplay(-1);
+                    break;
+                case ']':
+                    seekReplay(1);
+                    break;
                 case 'q':
                 case 'Q':
                     gameOver = true;
@@ -456,186 +724,783 @@ private:
         }
     }
 
+    // Rewinding would desynchronise a recording from its inputs
+    bool canRewind() const {
+        return !replaying && !recorder.isOpen() && rewindBuffer.available() > 0;
+    }
+
+    // Take back about REWIND_STEP_MS of play and pause so the player can
+    // get their bearings
+    void rewind() {
+        if (!canRewind()) return;
+        rewindBuffer.rewind(engine, std::max(1, REWIND_STEP_MS / engine.speed()));
+        renderer.invalidate();
+        if (autopilot) autopilot->newGame(engine);
+        if (bot) bot->newGame(engine);
+        nextDirection = NONE;
+        turns.clear();
+        gameOver = false;
+        paused = true;
+    }
+
+    // Compose and send a frame even if the writer is still busy with the
+    // last one, for screens that will not be redrawn until something changes
+    void renderNow() {
+        writer.waitIdle();
+        render();
+    }
+
+    // The terminal changed size mid-game: refit the viewport (the board
+    // keeps its size) and repaint once from a cleared screen
+    void relayout() {
+        fitViewport();
+        renderer.invalidate();
+        writer.waitIdle();
+        clearScreen();
+        render();
+    }
+
+    // Paint the paused frame once, then sleep until a key or a resize
+    // arrives, instead of ticking. Deadlines restart on resume.
+    void waitWhilePaused() {
+        renderNow();
+        while (paused && !gameOver) {
+            if (keyboard->waitForInput(-1)) {
+                FrameStats::Clock::time_point start = FrameStats::Clock::now();
+                processInput();
+                stats.record(PHASE_INPUT, FrameStats::Clock::now() - start);
+            } else if (keyboard->closed()) {
+                gameOver = true;  // Nothing can unpause the game
+                break;
+            }
+            if (keyboard->takeResize()) {
+                relayout();
+            }
+            renderNow();  // Pause banner or rewind; nothing if unchanged
+        }
+        scheduler.start(engine.speed());
+    }
+
+    // Service input as it arrives until the next tick is due
+    void waitForTick() {
+        int remaining;
+        while (!gameOver && !paused && (remaining = scheduler.millisUntilDeadline()) > 0) {
+            if (keyboard && keyboard->waitForInput(remaining)) {
+                FrameStats::Clock::time_point start = FrameStats::Clock::now();
+                processInput();
+                stats.record(PHASE_INPUT, FrameStats::Clock::now() - start);
+            } else if (!keyboard) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(remaining));
+            }
+            if (keyboard && keyboard->takeResize()) {
+                relayout();
+            }
+        }
+        scheduler.beginTick();
+    }
+
 public:
     SnakeGame()
-        : direction(NONE),
-          nextDirection(NONE),
+        : nextDirection(NONE),
           gameOver(false),
           paused(false),
-          score(0),
-          speed(INITIAL_SPEED),
+          replaying(false),
+          replaySpeed(1),
+          replayStart(0),
+          rewindBuffer(REWIND_HISTORY_TICKS),
+          fixedSeed(false),
+          seedValue(0),
           boardWidth(DEFAULT_WIDTH),
           boardHeight(DEFAULT_HEIGHT),
+          worldWidth(0),
+          worldHeight(0),
           terminalWidth(0),
           terminalHeight(0),
-          sizeWarning(false) {
-        srand(static_cast<unsigned>(time(nullptr)));
+          sizeWarning(false),
+          statsHud(false) {
+    }
+
+    // Use the same food seed for every game instead of a clock-derived one
+    void setSeed(uint64_t seed) {
+        fixedSeed = true;
+        seedValue = seed;
+    }
+
+    // Play on a fixed-size world, viewed through a window that follows the head
+    void setWorld(int width, int height) {
+        worldWidth = width;
+        worldHeight = height;
+    }
+
+    bool startRecording(const std::string& path) {
+        return recorder.open(path);
+    }
+
+    // Let the autopilot steer; the keyboard still pauses and quits
+    void setAutopilot(int budgetMicros) {
+        autopilot = createPolicy(POLICY_AUTOPILOT, 0, budgetMicros);
+    }
+
+    // Publish every tick to a shared-memory region and steer with the
+    // moves a bot process writes back; see snake_bot.h
+    bool startBot(const std::string& path, bool lockstep, std::string& error) {
+        long long cells = worldWidth > 0
+            ? static_cast<long long>(worldWidth) * worldHeight
+            : static_cast<long long>(DEFAULT_WIDTH) * DEFAULT_HEIGHT;
+        bot.reset(new BotLink());
+        if (!bot->open(path, static_cast<int>(std::min<long long>(cells, MAX_BOT_CELLS + 1LL)), lockstep)) {
+            error = bot->error();
+            bot.reset();
+            return false;
+        }
+        return true;
+    }
+
+    bool startReplay(const std::string& path, long long startTick) {
+        replaying = replayFile.open(path) && replay.open(replayFile.data(), replayFile.size());
+        replayStart = startTick;
+        return replaying;
+    }
+
+    // Jump a twentieth of the replayed game forwards (1) or back (-1)
+    void seekReplay(int direction) {
+        if (!replaying) return;
+        long long step = std::max<long long>(REPLAY_SEEK_MIN_TICKS, replay.gameTicks() / REPLAY_SEEK_STEPS);
+        long long target = replay.tick() + direction * step;
+        replay.seek(engine, std::max(0LL, std::min(target, replay.gameTicks())));
+        renderer.invalidate();
+    }
+
+    void replayStatus(std::string& out) const {
+        char status[96];
+        snprintf(status, sizeof(status), "Replay %dx  tick %lld/%lld", replaySpeed,
+                 replay.tick(), replay.gameTicks());
+        out = status;
     }
 
-    void reset() {
+    void setDeltaRendering(bool enabled) {
+        renderer.setDeltaRendering(enabled);
+    }
+
+    void setStatsHud(bool enabled) {
+        statsHud = enabled;
+    }
+
+    // Dump frame timing histograms and byte counts; CSV or JSON by extension
+    bool writeStats(const std::string& path) {
+        stats.setSchedule(scheduler.tickCount(), scheduler.lateTickCount(),
+                          scheduler.resyncCount(), scheduler.worstLagMs());
+        return stats.write(path);
+    }
+
+    // Start the next game; false when replaying and the recording has no
+    // games left
+    bool reset() {
         updateBoardDimensions();
 
-        snake.clear();
-        int centerX = boardWidth / 2;
-        int centerY = boardHeight / 2;
+        uint64_t seed = fixedSeed ? seedValue
+            : static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        if (replaying) {
+            // Recorded board size wins over the terminal so food lands identically
+            if (!replay.nextGame(boardWidth, boardHeight, seed)) {
+                return false;
+            }
+        }
 
-        snake.push_back({centerX, centerY});
-        if (boardWidth > 1) {
-            snake.push_back({std::max(0, centerX - 1), centerY});
+        engine.reset(boardWidth, boardHeight, seed);
+        if (replaying && replayStart > 0) {
+            replay.seek(engine, replayStart);
+            replayStart = 0;
         }
-        if (boardWidth > 2) {
-            snake.push_back({std::max(0, centerX - 2), centerY});
+        rewindBuffer.clear();
+        recorder.beginGame(boardWidth, boardHeight, seed);
+        if (autopilot) {
+            autopilot->newGame(engine);
         }
+        if (bot) {
+            bot->newGame(engine);
+        }
+        engine.setChangeTracking(renderer.deltaRendering());
+        renderer.setWarning(sizeWarning ? sizeWarningMessage : std::string());
+        renderer.invalidate();
 
-        direction = NONE;
         nextDirection = NONE;
         gameOver = false;
         paused = false;
-        score = 0;
-        speed = INITIAL_SPEED;
 
+        turns.clear();
         if (keyboard) {
-            while (keyboard->kbhit()) {
-                keyboard->getch();
-            }
+            keyboard->flush();
         }
-
-        spawnFood();
+        return true;
     }
 
-    void showWelcomeScreen() {
+    void drawWelcomeScreen() {
         clearScreen();
-        std::cout << "\n\n";
-        std::cout << GREEN << BOLD;
-        std::cout << "    ███████╗███╗   ██╗ █████╗ ██╗  ██╗███████╗\n";
-        std::cout << "    ██╔════╝████╗  ██║██╔══██╗██║ ██╔╝██╔════╝\n";
-        std::cout << "    ███████╗██╔██╗ ██║███████║█████╔╝ █████╗  \n";
-        std::cout << "    ╚════██║██║╚██╗██║██╔══██║██╔═██╗ ██╔══╝  \n";
-        std::cout << "    ███████║██║ ╚████║██║  ██║██║  ██╗███████╗\n";
-        std::cout << "    ╚══════╝╚═╝  ╚═══╝╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝\n";
-        std::cout << RESET << "\n\n";
-
-        std::cout << CYAN << "  ╔════════════════════════════════════════╗\n";
-        std::cout << "  ║  " << WHITE << "Classic Snake Game in C++        " << CYAN << "     ║\n";
-        std::cout << "  ╚════════════════════════════════════════╝" << RESET << "\n\n";
-
-        std::cout << YELLOW << "  How to Play:\n" << RESET;
-        std::cout << "  • Use " << GREEN << "WASD" << RESET << " or " << GREEN << "Arrow Keys" << RESET << " to move\n";
-        std::cout << "  • Eat the " << RED << "red food" << RESET << " to grow\n";
-        std::cout << "  • Don't hit walls or yourself!\n";
-        std::cout << "  • Press " << MAGENTA << "SPACE" << RESET << " to pause\n";
-        std::cout << "  • The game speeds up as you score!\n\n";
-
-        std::cout << BOLD << "  Press ENTER to start..." << RESET << std::flush;
-
-        // Use simple getline before keyboard is initialized
-        std::string dummy;
-        std::getline(std::cin, dummy);
-
-        // Clear cin state and flush any remaining input
-        std::cin.clear();
-        std::cin.sync();
-
-        // Now initialize keyboard input (switches to non-blocking mode)
-        keyboard.reset(new KeyboardInput());
+        std::string screen;
+        appendWelcomeScreen(screen);
+        std::cout << screen << std::flush;
+    }
 
-        // Clear any buffered input after mode switch
-        if (keyboard) {
-            while (keyboard->kbhit()) {
-                keyboard->getch();
+    // Wait for a key, with no timeout, that `accept` returns true for.
+    // Repaints with `draw` after a resize. Returns 0 if stdin is closed.
+    template <class Accept, class Draw>
+    char waitForKey(Accept accept, Draw draw) {
+        char key;
+        for (;;) {
+            while (keyboard->nextKey(key)) {
+                if (accept(key)) return key;
+            }
+            if (keyboard->closed()) return 0;
+            keyboard->waitForInput(-1);
+            if (keyboard->takeResize()) {
+                draw();
             }
         }
+    }
+
+    void showWelcomeScreen() {
+        // Switch the terminal to raw, non-blocking input first, discarding
+        // anything typed before the screen appeared
+        keyboard.reset(new KeyboardInput());
+        keyboard->flush();
+
+        drawWelcomeScreen();
+        waitForKey([](char key) { return key == '\n' || key == '\r'; },
+                   [this] { drawWelcomeScreen(); });
 
         // Small delay to ensure terminal is ready
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
 
-    bool showGameOverScreen() {
+    void drawGameOverScreen(bool offerRewind) {
         printf("\033[2J\033[1;1H");  // Clear screen and home cursor
         fflush(stdout);
-        std::cout << "\n\n";
-        std::cout << RED << BOLD;
-        std::cout << "    ╔═══════════════════════════════════════╗\n";
-        std::cout << "    ║                                       ║\n";
-        std::cout << "    ║               GAME OVER!              ║\n";
-        std::cout << "    ║                                       ║\n";
-        std::cout << "    ╚═══════════════════════════════════════╝\n";
-        std::cout << RESET << "\n";
-
-        std::cout << YELLOW << "    Final Score: " << BOLD << score << RESET << "\n";
-        std::cout << MAGENTA << "    Snake Length: " << BOLD << snake.size() << RESET << "\n\n";
-
-        if (score >= 50) {
-            std::cout << GREEN << BOLD << "    🏆 LEGENDARY! You're a Snake Master! 🏆\n" << RESET;
-        } else if (score >= 30) {
-            std::cout << CYAN << BOLD << "    ⭐ AMAZING! Excellent skills! ⭐\n" << RESET;
-        } else if (score >= 15) {
-            std::cout << BLUE << BOLD << "    👍 Great job! Keep practicing!\n" << RESET;
-        } else {
-            std::cout << WHITE << "    Good try! Practice makes perfect!\n" << RESET;
-        }
+        std::string screen;
+        appendGameOverScreen(screen, engine.score(), engine.body().size(), offerRewind);
+        std::cout << screen << std::flush;
+    }
 
-        std::cout << "\n    " << WHITE << "Press " << GREEN << "R" << WHITE << " to play again or " << RED << "Q" << WHITE << " to quit..." << RESET << std::flush;
+    GameOverChoice showGameOverScreen() {
+        bool offerRewind = canRewind();
+        drawGameOverScreen(offerRewind);
 
         // Clear any buffered input first
-        while (keyboard->kbhit()) {
-            keyboard->getch();
-        }
-        
-        char key = 0;
-        do {
-            if (keyboard->kbhit()) {
-                key = keyboard->getch();
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        } while (key != 'r' && key != 'R' && key != 'q' && key != 'Q');
+        keyboard->flush();
+
+        char key = waitForKey(
+            [offerRewind](char k) {
+                return k == 'r' || k == 'R' || k == 'q' || k == 'Q' ||
+                       (offerRewind && (k == 'b' || k == 'B'));
+            },
+            [this, offerRewind] { drawGameOverScreen(offerRewind); });
 
         if (key == 'r' || key == 'R') {
-            return true;
+            return CHOICE_RESTART;
+        }
+        if (key == 'b' || key == 'B') {
+            return CHOICE_REWIND;
         }
 
-        return false;
+        return CHOICE_QUIT;
+    }
+
+    // Advance the simulation by one tick unless paused; a fast-forwarded
+    // replay plays several recorded ticks per tick
+    void tick() {
+        if (paused) return;
+        int steps = replaying ? replaySpeed : 1;
+        for (int i = 0; i < steps && !gameOver; ++i) {
+            playTick();
+        }
+    }
+
+    void playTick() {
+        turns.pop(nextDirection);
+
+        if (autopilot && !replaying) {
+            nextDirection = autopilot->choose(engine);
+        }
+        if (bot && !replaying) {
+            // A lock-step bot that misses its reply leaves the snake going straight
+            bot->nextMove(nextDirection, BOT_REPLY_TIMEOUT_MS);
+        }
+
+        Direction input = nextDirection;
+        if (replaying && !replay.nextInput(input)) {
+            gameOver = true;  // Recording ends where the player quit
+            return;
+        }
+        recorder.record(input, engine);
+        if (rewindBuffer.step(engine, input) == STEP_GAME_OVER) {
+            gameOver = true;
+        }
+        if (bot) {
+            bot->publish(engine);
+        }
+    }
+
+    // One-line summary of frame timing problems, if there were any
+    void printTimingStats() const {
+        if (scheduler.lateTickCount() == 0) return;
+        printf("  Timing: %lld ticks, %lld late (frames skipped), %lld resyncs, worst lag %.1f ms\n\n",
+               scheduler.tickCount(), scheduler.lateTickCount(),
+               scheduler.resyncCount(), scheduler.worstLagMs());
+        fflush(stdout);
     }
 
     void run() {
         bool keepPlaying = true;
+        bool resume = false;  // Continue the rewound game instead of starting anew
 
+        writer.start();
         while (keepPlaying) {
             initTerminal();
-            reset();
+            if (!resume && !reset()) {
+                restoreTerminal();
+                break;
+            }
+            resume = false;
 
-            while (!gameOver) {
-                processInput();
+            render();
+            scheduler.start(engine.speed());
 
-                if (!paused) {
-                    moveSnake();
+            while (!gameOver) {
+                if (paused && keyboard) {
+                    waitWhilePaused();
+                    continue;
                 }
-
-                render();
-
-                std::this_thread::sleep_for(std::chrono::milliseconds(speed));
+                waitForTick();
+                if (gameOver) break;
+                FrameStats::Clock::time_point frameStart = FrameStats::Clock::now();
+                tick();
+                stats.record(PHASE_TICK, FrameStats::Clock::now() - frameStart);
+
+                // Simulation keeps its rate; frames are dropped while behind
+                if (scheduler.advance(engine.speed())) {
+                    render();
+                }
+                stats.record(PHASE_FRAME, FrameStats::Clock::now() - frameStart);
             }
 
             // Show game over screen while still in alternate buffer
-            keepPlaying = showGameOverScreen();
+            writer.waitIdle();
+            GameOverChoice choice = showGameOverScreen();
+            keepPlaying = choice != CHOICE_QUIT;
             
             // Exit alternate buffer before next iteration or exit
             restoreTerminal();
+            if (choice == CHOICE_REWIND) {
+                rewind();
+                resume = true;
+            }
             
             // Small delay before re-initializing if replaying
             if (keepPlaying) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
         }
+        writer.stop();
     }
 };
 
-int main() {
+// Append `value` in decimal, for fast CSV output
+char* appendDecimal(char* out, long long value) {
+    char digits[24];
+    int count = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) *out++ = '-';
+    while (count > 0) *out++ = digits[--count];
+    return out;
+}
+
+// Re-simulate a recording as fast as possible and print each game's outcome.
+// The first game can start at `startTick`, reached through the nearest
+// keyframe, and every tick's state can be written to `tickStatsPath` as CSV.
+int runHeadlessReplay(const std::string& path, long long startTick, const std::string& tickStatsPath) {
+    MappedFile file;
+    InputReplay replay;
+    if (!file.open(path) || !replay.open(file.data(), file.size())) {
+        std::cerr << "Cannot read recording: " << path << "\n";
+        return 1;
+    }
+    FILE* statsFile = nullptr;
+    if (!tickStatsPath.empty()) {
+        statsFile = fopen(tickStatsPath.c_str(), "wb");
+        if (!statsFile) {
+            std::cerr << "Cannot write tick statistics: " << tickStatsPath << "\n";
+            return 1;
+        }
+        fputs("game,tick,score,length,head_x,head_y,food_x,food_y\n", statsFile);
+    }
+    std::vector<char> pending(TICK_STATS_FLUSH_BYTES + 256);
+    char* out = pending.data();
+
+    SnakeEngine engine;
+    int width, height;
+    uint64_t seed;
+    int game = 0;
+    bool ok = true;
+    while (replay.nextGame(width, height, seed)) {
+        engine.reset(width, height, seed);
+        game++;
+        if (game == 1 && startTick > 0) {
+            FrameStats::Clock::time_point start = FrameStats::Clock::now();
+            if (!replay.seek(engine, startTick)) {
+                std::cerr << "Game 1 has only " << replay.gameTicks() << " ticks\n";
+                ok = false;
+                break;
+            }
+            printf("game 1: reached tick %lld in %.3f ms\n", startTick,
+                   std::chrono::duration<double, std::milli>(FrameStats::Clock::now() - start).count());
+        }
+        Direction input;
+        while (!engine.isOver() && replay.nextInput(input)) {
+            engine.step(input);
+            if (statsFile) {
+                out = appendDecimal(out, game);
+                *out++ = ',';
+                out = appendDecimal(out, replay.tick());
+                *out++ = ',';
+                out = appendDecimal(out, engine.score());
+                *out++ = ',';
+                out = appendDecimal(out, static_cast<long long>(engine.body().size()));
+                *out++ = ',';
+                out = appendDecimal(out, engine.head().x);
+                *out++ = ',';
+                out = appendDecimal(out, engine.head().y);
+                *out++ = ',';
+                out = appendDecimal(out, engine.food().x);
+                *out++ = ',';
+                out = appendDecimal(out, engine.food().y);
+                *out++ = '\n';
+                if (static_cast<size_t>(out - pending.data()) >= TICK_STATS_FLUSH_BYTES) {
+                    fwrite(pending.data(), 1, out - pending.data(), statsFile);
+                    out = pending.data();
+                }
+            }
+        }
+        Point head = engine.head();
+        printf("game %d: %dx%d seed=%llu ticks=%lld score=%d length=%d head=%d,%d end=%s\n",
+               game, width, height, static_cast<unsigned long long>(seed), replay.tick(),
+               engine.score(), static_cast<int>(engine.body().size()), head.x, head.y,
+               engine.isOver() ? endReasonName(engine.reason()) : "quit");
+    }
+    if (statsFile) {
+        fwrite(pending.data(), 1, out - pending.data(), statsFile);
+        if (fclose(statsFile) != 0) {
+            std::cerr << "Cannot write tick statistics: " << tickStatsPath << "\n";
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// Play games back to back with a lock-step bot and no terminal, as fast as
+// the bot answers, until it replies BOT_QUIT or stops answering
+int runHeadlessBot(const std::string& path, const BatchConfig& config) {
+    BotLink bot;
+    long long cells = static_cast<long long>(config.width) * config.height;
+    if (!bot.open(path, static_cast<int>(std::min<long long>(cells, MAX_BOT_CELLS + 1LL)), true)) {
+        std::cerr << "Cannot open bot region: " << bot.error() << "\n";
+        return 1;
+    }
+    printf("Waiting for a bot on %s\n", path.c_str());
+    fflush(stdout);
+
+    SnakeEngine engine;
+    long long maxTicks = config.maxTicks > 0 ? config.maxTicks
+                                             : 100LL * config.width * config.height;
+    BatchStats totals;
+    bool stalled = false;
+    for (long long game = 0; !bot.quitRequested() && !stalled; ++game) {
+        engine.reset(config.width, config.height, batchGameSeed(config.baseSeed, game));
+        bot.newGame(engine);
+        long long ticks = 0;
+        Direction move;
+        while (!engine.isOver() && ticks < maxTicks) {
+            int timeout = bot.replies() > 0 ? BOT_REPLY_TIMEOUT_MS : BOT_ATTACH_TIMEOUT_MS;
+            if (!bot.nextMove(move, timeout)) {
+                stalled = true;
+                break;
+            }
+            if (bot.quitRequested()) break;
+            engine.step(move);
+            bot.publish(engine);
+            ticks++;
+        }
+        if (ticks == 0) break;
+        printf("game %lld: score=%d length=%d ticks=%lld end=%s\n", game + 1, engine.score(),
+               static_cast<int>(engine.body().size()), ticks,
+               engine.isOver() ? endReasonName(engine.reason()) : "stopped");
+        totals.add(engine.score(), static_cast<int>(engine.body().size()), ticks, engine.reason());
+    }
+
+    printf("bot: %lld games, %lld moves, mean reply %.1f us\n",
+           totals.games, bot.replies(), bot.meanReplyMicros());
+    if (stalled) {
+        std::cerr << "The bot stopped answering\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Play a batch of headless games across all cores and print the aggregate
+int runBatchMode(const BatchConfig& config) {
+    BatchReport report = runBatch(config);
+    const BatchStats& totals = report.totals;
+    double games = totals.games > 0 ? static_cast<double>(totals.games) : 1.0;
+
+    printf("games:     %lld on %dx%d, %d threads, %.3f s (%.0f games/s, %.2f M ticks/s, %lld steals)\n",
+           totals.games, config.width, config.height, report.threads, report.seconds,
+           totals.games / report.seconds, totals.ticks / report.seconds / 1e6, report.steals);
+    printf("score:     mean %.2f, min %d, max %d\n",
+           totals.scoreSum / games, totals.minScore, totals.maxScore);
+    printf("length:    mean %.2f\n", totals.lengthSum / games);
+    printf("ticks:     mean %.1f, total %lld\n", totals.ticks / games, totals.ticks);
+    printf("end:       wall %lld, self %lld, board-full %lld, tick-limit %lld\n",
+           totals.endCounts[END_WALL], totals.endCounts[END_SELF],
+           totals.endCounts[END_BOARD_FULL], totals.endCounts[END_NONE]);
+    return 0;
+}
+
+int runArenaMode(const ArenaConfig& config) {
+    ArenaReport report = runArena(config);
+    printf("arena:     %d snakes on %dx%d, %d threads, %.3f s (%.0f ticks/s, %.2f M snake-ticks/s)\n",
+           config.snakes, config.width, config.height, report.threads, report.seconds,
+           report.ticks / report.seconds, report.ticks * config.snakes / report.seconds / 1e6);
+    printf("ticks:     %lld\n", report.ticks);
+    printf("snakes:    %d alive, longest %d\n", report.alive, report.longest);
+    printf("food:      %lld eaten\n", report.eaten);
+    printf("deaths:    wall %lld, body %lld, head-on %lld\n",
+           report.deaths[DEATH_WALL], report.deaths[DEATH_BODY], report.deaths[DEATH_HEAD_ON]);
+    printf("checksum:  %016llx\n", static_cast<unsigned long long>(report.checksum));
+    return 0;
+}
+
+int runServerMode(const ServerConfig& config) {
+    GameServer server(config);
+    if (!server.open()) {
+        std::cerr << "Cannot serve on " << config.address << ": " << server.error() << "\n";
+        return 1;
+    }
+    printf("Serving snake on %s, up to %d sessions (Ctrl+C to stop)\n",
+           config.address.c_str(), config.maxSessions);
+    fflush(stdout);
+    bool ok = server.run();
+
+    const ServerReport& report = server.report();
+    printf("sessions:  %lld served, %d at peak\n", report.sessions, report.peakSessions);
+    printf("games:     %lld, %lld ticks\n", report.games, report.ticks);
+    printf("output:    %lld bytes, %lld frames dropped\n", report.bytesSent, report.droppedFrames);
+    printf("watching:  %lld spectators, %lld skipped ahead to a keyframe\n",
+           report.spectators, report.viewerSkips);
+    if (!ok) {
+        std::cerr << "Server stopped: " << server.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// The autopilot keeps dense per-cell planning state, so it only plays boards
+// that keep a free list
+bool autopilotFits(int width, int height) {
+    return static_cast<long long>(width) * height <= LARGE_BOARD_CELLS;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --full-redraw      Repaint the whole screen every frame\n"
+              << "  --world WxH        Play on a WxH world that scrolls with the snake\n"
+              << "  --seed N           Use food seed N for every game\n"
+              << "  --record FILE      Record seeds and inputs to FILE\n"
+              << "  --replay FILE      Play back a recording\n"
+              << "  --headless         With --replay, re-simulate without a terminal and print results\n"
+              << "  --seek TICK        Start replaying the first game at TICK\n"
+              << "  --tick-stats FILE  With --replay --headless, write every tick's state to FILE (CSV)\n"
+              << "  --batch N          Play N headless games with a bot and print aggregate results\n"
+              << "  --threads N        Worker threads for --batch (default: all cores)\n"
+              << "  --size WxH         Board size for --batch (default 40x20)\n"
+              << "  --max-ticks N      Per-game tick limit for --batch\n"
+              << "  --policy NAME      Bot for --batch: greedy or autopilot\n"
+              << "  --arena N          Run N bot snakes on one shared board and print results\n"
+              << "                     (uses --size, default 256x256; --max-ticks, default 10000;\n"
+              << "                     --threads and --seed)\n"
+              << "  --food N           Food items kept on the --arena board (default 2 per snake)\n"
+              << "  --autopilot        Let the autopilot play\n"
+              << "  --budget US        Autopilot planning time per tick in microseconds\n"
+              << "                     (default 500 live, unlimited for --batch)\n"
+              << "  --stats FILE       Write frame timing statistics to FILE on exit (.csv or JSON)\n"
+              << "  --stats-hud        Show frame timings on the HUD line\n"
+              << "  --serve ADDRESS    Host games for many players at once on PORT (loopback),\n"
+              << "                     HOST:PORT (telnet) or unix:PATH (raw terminal stream)\n"
+              << "  --max-sessions N   Players --serve accepts at once (default 4096)\n"
+              << "  --bot PATH         Let a bot process play through shared memory at PATH\n"
+              << "  --bot-lockstep     Wait for the bot's move every tick; with --headless, play\n"
+              << "                     --size games back to back as fast as the bot answers\n";
+}
+
+int main(int argc, char* argv[]) {
     SnakeGame game;
+    std::string recordPath;
+    std::string replayPath;
+    bool headless = false;
+    bool batch = false;
+    bool arena = false;
+    bool sizeGiven = false;
+    bool seedGiven = false;
+    ArenaConfig arenaConfig;
+    bool useAutopilot = false;
+    int budgetMicros = -1;
+    std::string statsPath;
+    int worldWidth = 0;
+    int worldHeight = 0;
+    BatchConfig batchConfig;
+    bool serve = false;
+    ServerConfig serverConfig;
+    std::string botPath;
+    long long seekTick = 0;
+    std::string tickStatsPath;
+    bool botLockstep = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--full-redraw") {
+            game.setDeltaRendering(false);
+        } else if (arg == "--seed" && hasValue) {
+            batchConfig.baseSeed = strtoull(argv[++i], nullptr, 10);
+            game.setSeed(batchConfig.baseSeed);
+            seedGiven = true;
+        } else if (arg == "--record" && hasValue) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            replayPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--seek" && hasValue) {
+            seekTick = std::max(0LL, strtoll(argv[++i], nullptr, 10));
+        } else if (arg == "--tick-stats" && hasValue) {
+            tickStatsPath = argv[++i];
+        } else if (arg == "--batch" && hasValue) {
+            batch = true;
+            batchConfig.games = strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            batchConfig.threads = atoi(argv[++i]);
+        } else if (arg == "--size" && hasValue &&
+                   sscanf(argv[i + 1], "%dx%d", &batchConfig.width, &batchConfig.height) == 2 &&
+                   batchConfig.width > 0 && batchConfig.height > 0) {
+            ++i;
+            sizeGiven = true;
+        } else if (arg == "--arena" && hasValue) {
+            arena = true;
+            arenaConfig.snakes = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--food" && hasValue) {
+            arenaConfig.food = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--world" && hasValue &&
+                   sscanf(argv[i + 1], "%dx%d", &worldWidth, &worldHeight) == 2 &&
+                   worldWidth > 0 && worldHeight > 0) {
+            ++i;
+            game.setWorld(worldWidth, worldHeight);
+        } else if (arg == "--max-ticks" && hasValue) {
+            batchConfig.maxTicks = strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--policy" && hasValue && parsePolicyKind(argv[i + 1], batchConfig.policy)) {
+            ++i;
+        } else if (arg == "--stats" && hasValue) {
+            statsPath = argv[++i];
+        } else if (arg == "--stats-hud") {
+            game.setStatsHud(true);
+        } else if (arg == "--autopilot") {
+            useAutopilot = true;
+        } else if (arg == "--budget" && hasValue) {
+            budgetMicros = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--serve" && hasValue) {
+            serve = true;
+            serverConfig.address = argv[++i];
+        } else if (arg == "--max-sessions" && hasValue) {
+            serverConfig.maxSessions = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--bot" && hasValue) {
+            botPath = argv[++i];
+        } else if (arg == "--bot-lockstep") {
+            botLockstep = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (serve) {
+        serverConfig.fixedSeed = seedGiven;
+        serverConfig.seed = batchConfig.baseSeed;
+        return runServerMode(serverConfig);
+    }
+    if (arena) {
+        if (sizeGiven) {
+            arenaConfig.width = batchConfig.width;
+            arenaConfig.height = batchConfig.height;
+        }
+        if (batchConfig.maxTicks > 0) {
+            arenaConfig.ticks = batchConfig.maxTicks;
+        }
+        arenaConfig.threads = batchConfig.threads;
+        arenaConfig.seed = batchConfig.baseSeed;
+        return runArenaMode(arenaConfig);
+    }
+    if (batch) {
+        if (batchConfig.policy == POLICY_AUTOPILOT && !autopilotFits(batchConfig.width, batchConfig.height)) {
+            std::cerr << "The autopilot cannot play boards over " << LARGE_BOARD_CELLS << " cells\n";
+            return 1;
+        }
+        batchConfig.budgetMicros = std::max(budgetMicros, 0);
+        return runBatchMode(batchConfig);
+    }
+    if (headless && !botPath.empty()) {
+        return runHeadlessBot(botPath, batchConfig);
+    }
+    if (headless) {
+        if (replayPath.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return runHeadlessReplay(replayPath, seekTick, tickStatsPath);
+    }
+    if (!replayPath.empty() && !game.startReplay(replayPath, seekTick)) {
+        std::cerr << "Cannot read recording: " << replayPath << "\n";
+        return 1;
+    }
+    if (!recordPath.empty() && !game.startRecording(recordPath)) {
+        std::cerr << "Cannot write recording: " << recordPath << "\n";
+        return 1;
+    }
+
+    if (useAutopilot) {
+        if (worldWidth > 0 && !autopilotFits(worldWidth, worldHeight)) {
+            std::cerr << "The autopilot cannot play worlds over " << LARGE_BOARD_CELLS << " cells\n";
+            return 1;
+        }
+        game.setAutopilot(budgetMicros >= 0 ? budgetMicros : AUTOPILOT_BUDGET_MICROS);
+    }
+    std::string botError;
+    if (!botPath.empty() && !game.startBot(botPath, botLockstep, botError)) {
+        std::cerr << "Cannot open bot region: " << botError << "\n";
+        return 1;
+    }
+
     game.showWelcomeScreen();
     game.run();
 
-    std::cout << "\n\n  " << CYAN << "Thanks for playing! 🐍\n\n" << RESET;
+    std::cout << "\n\n  " << CYAN << "Thanks for playing! 🐍\n\n" << RESET << std::flush;
+    game.printTimingStats();
+    if (!statsPath.empty() && !game.writeStats(statsPath)) {
+        std::cerr << "Cannot write statistics: " << statsPath << "\n";
+        return 1;
+    }
 
     return 0;
 }
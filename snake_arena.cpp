@@ -0,0 +1,436 @@
+#include "snake_arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const int FOOD_SIGHT = 6;          // Bots look for food this many cells around the head
+const int PLACE_ATTEMPTS = 64;     // Random tries to fit a snake or a food item
+const uint32_t WANDER_TURN_ODDS = 16;  // Bots with no food in sight turn 1 tick in N
+
+// Reusable barrier: the last of `parties` threads to arrive releases the rest
+class TickBarrier {
+public:
+    explicit TickBarrier(int parties) : parties(parties), waiting(0), phase(0) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned long arrivedIn = phase;
+        if (++waiting == parties) {
+            waiting = 0;
+            phase++;
+            released.notify_all();
+        } else {
+            released.wait(lock, [&] { return phase != arrivedIn; });
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    int parties;
+    int waiting;
+    unsigned long phase;
+};
+
+} // namespace
+
+ArenaEngine::ArenaEngine()
+    : generation(0),
+      boardWidth(0),
+      boardHeight(0),
+      targetFood(0),
+      foodItems(0),
+      living(0),
+      respawn(true),
+      tickCount(0),
+      eaten(0) {
+    std::fill(deathCounts, deathCounts + DEATH_KIND_COUNT, 0LL);
+}
+
+void ArenaEngine::reset(int width, int height, int snakeTotal, int food, uint64_t seed) {
+    boardWidth = std::min(std::max(width, 1), MAX_BOARD_CELLS);
+    boardHeight = std::min(std::max(height, 1), MAX_BOARD_CELLS / boardWidth);
+    cellGrid.reset(boardWidth, boardHeight);
+    rng.reseed(seed);
+    targetFood = std::max(food, 0);
+    foodItems = 0;
+    living = 0;
+    tickCount = 0;
+    eaten = 0;
+    std::fill(deathCounts, deathCounts + DEATH_KIND_COUNT, 0LL);
+
+    // Two entries per snake (head and tail) at most, kept under a quarter full
+    size_t tableSize = 16;
+    while (tableSize < static_cast<size_t>(std::max(snakeTotal, 0)) * 8) tableSize *= 2;
+    table.assign(tableSize, CellSlot());
+    generation = 0;
+
+    snakes.assign(std::max(snakeTotal, 0), ArenaSnake());
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        ArenaSnake& s = snakes[i];
+        s.score = 0;
+        s.alive = false;
+        s.deadTicks = 0;
+        s.moving = false;
+        place(s);
+    }
+    spawnFood();
+}
+
+void ArenaEngine::steer(int id, Direction d) {
+    snakes[id].requested = d;
+}
+
+// Find or insert the table entry for `cell` in this tick's generation
+ArenaEngine::CellSlot& ArenaEngine::slotFor(int cell) {
+    size_t mask = table.size() - 1;
+    size_t i = (static_cast<uint32_t>(cell) * 0x9E3779B1u) & mask;
+    for (;;) {
+        CellSlot& slot = table[i];
+        if (slot.generation != generation) {
+            slot.cell = cell;
+            slot.generation = generation;
+            slot.heads = 0;
+            slot.vacating = false;
+            return slot;
+        }
+        if (slot.cell == cell) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+// Drop a new snake on a random free stretch of START_LENGTH cells
+bool ArenaEngine::place(ArenaSnake& s) {
+    for (int attempt = 0; attempt < PLACE_ATTEMPTS; ++attempt) {
+        Point head = {static_cast<int>(rng.below(static_cast<uint32_t>(boardWidth))),
+                      static_cast<int>(rng.below(static_cast<uint32_t>(boardHeight)))};
+        Direction d = static_cast<Direction>(rng.below(4));
+        Point tail = head;
+        bool fits = true;
+        for (int i = 0; i < START_LENGTH && fits; ++i) {
+            fits = inBounds(tail) && cellAt(tail.x, tail.y) == CELL_EMPTY;
+            if (i + 1 < START_LENGTH) tail = stepPoint(tail, reverseOf(d));
+        }
+        // Leave room ahead so a new snake does not spawn facing a wall
+        Point ahead = stepPoint(head, d);
+        if (!fits || !inBounds(ahead)) continue;
+
+        s.body.clear();
+        for (Point p = tail; ; p = stepPoint(p, d)) {
+            if (!s.body.empty()) cellGrid.set(s.body.head().x, s.body.head().y, CELL_BODY);
+            s.body.pushHead(p);
+            cellGrid.set(p.x, p.y, CELL_HEAD);
+            if (p == head) break;
+        }
+        s.direction = d;
+        s.requested = NONE;
+        s.score = 0;
+        s.alive = true;
+        s.deadTicks = 0;
+        living++;
+        return true;
+    }
+    return false;
+}
+
+// Clear a dead snake off the board, leaving food on every
+// DEAD_FOOD_STRIDE-th segment
+void ArenaEngine::kill(ArenaSnake& s, ArenaDeath cause) {
+    deathCounts[cause]++;
+    s.alive = false;
+    s.deadTicks = 0;
+    living--;
+    int index = 0;
+    for (SnakeBody::Iterator it = s.body.begin(); it != s.body.end(); ++it, ++index) {
+        Point p = *it;
+        // Another head may already have moved into this snake's vacated tail
+        if (p != s.body.head() && cellAt(p.x, p.y) == CELL_HEAD) continue;
+        if (index % DEAD_FOOD_STRIDE == 0) {
+            cellGrid.set(p.x, p.y, CELL_FOOD);
+            foodItems++;
+        } else {
+            cellGrid.set(p.x, p.y, CELL_EMPTY);
+        }
+    }
+    s.body.clear();
+}
+
+void ArenaEngine::spawnFood() {
+    int attempts = PLACE_ATTEMPTS + 2 * std::max(targetFood - foodItems, 0);
+    for (int attempt = 0; foodItems < targetFood && attempt < attempts; ++attempt) {
+        int x = static_cast<int>(rng.below(static_cast<uint32_t>(boardWidth)));
+        int y = static_cast<int>(rng.below(static_cast<uint32_t>(boardHeight)));
+        if (cellAt(x, y) == CELL_EMPTY) {
+            cellGrid.set(x, y, CELL_FOOD);
+            foodItems++;
+        }
+    }
+}
+
+void ArenaEngine::plan(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        ArenaSnake& s = snakes[i];
+        s.moving = s.alive;
+        if (!s.alive) continue;
+        if (s.requested != NONE && !isOpposite(s.direction, s.requested)) {
+            s.direction = s.requested;
+        }
+        s.requested = NONE;
+        s.next = stepPoint(s.body.head(), s.direction);
+        s.hitWall = !inBounds(s.next);
+        s.eating = !s.hitWall && cellAt(s.next.x, s.next.y) == CELL_FOOD;
+    }
+}
+
+void ArenaEngine::resolve() {
+    if (++generation == 0) {
+        for (size_t i = 0; i < table.size(); ++i) table[i].generation = 0;
+        generation = 1;
+    }
+
+    // Heads entering each cell, and tails leaving
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        const ArenaSnake& s = snakes[i];
+        if (!s.moving) continue;
+        if (!s.hitWall) {
+            slotFor(s.next.y * boardWidth + s.next.x).heads++;
+        }
+        if (!s.eating) {
+            Point tail = s.body.tail();
+            slotFor(tail.y * boardWidth + tail.x).vacating = true;
+        }
+    }
+
+    // Decide every death against the board as it was at the start of the
+    // tick. A tail that was due to leave stays enterable even if its snake
+    // dies this tick (kill() then keeps the head that moved in); the rest
+    // of a dying body still blocks
+    dying.clear();
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        ArenaSnake& s = snakes[i];
+        if (!s.moving) continue;
+        ArenaDeath cause = DEATH_KIND_COUNT;
+        if (s.hitWall) {
+            cause = DEATH_WALL;
+        } else {
+            CellSlot& slot = slotFor(s.next.y * boardWidth + s.next.x);
+            if (slot.heads > 1) {
+                cause = DEATH_HEAD_ON;
+            } else if (cellAt(s.next.x, s.next.y) >= CELL_BODY && !slot.vacating) {
+                cause = DEATH_BODY;
+            }
+        }
+        if (cause != DEATH_KIND_COUNT) {
+            s.moving = false;
+            dying.push_back(std::make_pair(static_cast<int>(i), cause));
+        }
+    }
+
+    // Vacate tails before any head moves in, then advance heads
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        ArenaSnake& s = snakes[i];
+        if (!s.moving || s.eating) continue;
+        Point tail = s.body.tail();
+        cellGrid.set(tail.x, tail.y, CELL_EMPTY);
+        s.body.popTail();
+    }
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        ArenaSnake& s = snakes[i];
+        if (!s.moving) continue;
+        Point head = s.body.head();
+        cellGrid.set(head.x, head.y, CELL_BODY);
+        s.body.pushHead(s.next);
+        cellGrid.set(s.next.x, s.next.y, CELL_HEAD);
+        if (s.eating) {
+            s.score++;
+            foodItems--;
+            eaten++;
+        }
+    }
+    for (size_t i = 0; i < dying.size(); ++i) {
+        kill(snakes[dying[i].first], dying[i].second);
+    }
+
+    if (respawn) {
+        for (size_t i = 0; i < snakes.size(); ++i) {
+            ArenaSnake& s = snakes[i];
+            if (!s.alive && ++s.deadTicks >= RESPAWN_TICKS) {
+                place(s);
+            }
+        }
+    }
+    spawnFood();
+    tickCount++;
+}
+
+void ArenaEngine::step() {
+    plan(0, snakeCount());
+    resolve();
+}
+
+uint64_t ArenaEngine::checksum() const {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < snakes.size(); ++i) {
+        const ArenaSnake& s = snakes[i];
+        uint64_t values[] = {
+            static_cast<uint64_t>(s.alive),
+            static_cast<uint64_t>(s.score),
+            static_cast<uint64_t>(s.body.size()),
+            static_cast<uint64_t>(s.body.head().x) << 32 | static_cast<uint32_t>(s.body.head().y),
+        };
+        for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); ++v) {
+            hash = (hash ^ values[v]) * 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+Direction chooseArenaMove(const ArenaEngine& arena, int id, GameRng& rng) {
+    const ArenaSnake& s = arena.snake(id);
+    if (!s.alive) return NONE;
+    Point head = s.body.head();
+
+    // Nearest food in sight, if any
+    Point target = head;
+    int targetDistance = -1;
+    for (int y = std::max(head.y - FOOD_SIGHT, 0); y <= std::min(head.y + FOOD_SIGHT, arena.height() - 1); ++y) {
+        for (int x = std::max(head.x - FOOD_SIGHT, 0); x <= std::min(head.x + FOOD_SIGHT, arena.width() - 1); ++x) {
+            if (arena.cellAt(x, y) != CELL_FOOD) continue;
+            int distance = std::abs(x - head.x) + std::abs(y - head.y);
+            if (targetDistance < 0 || distance < targetDistance) {
+                target.x = x;
+                target.y = y;
+                targetDistance = distance;
+            }
+        }
+    }
+
+    // Free cells ahead, preferring those no other head can also reach this
+    // tick, since meeting head-on kills both
+    Direction options[3];
+    int count = 0;
+    Direction contested[3];
+    int contestedCount = 0;
+    for (int d = UP; d <= RIGHT; ++d) {
+        if (static_cast<Direction>(d) == reverseOf(s.direction)) continue;
+        Point next = stepPoint(head, static_cast<Direction>(d));
+        if (!arena.inBounds(next) || arena.cellAt(next.x, next.y) >= CELL_BODY) continue;
+        bool nearHead = false;
+        for (int n = UP; n <= RIGHT && !nearHead; ++n) {
+            Point around = stepPoint(next, static_cast<Direction>(n));
+            nearHead = around != head && arena.inBounds(around) &&
+                       arena.cellAt(around.x, around.y) == CELL_HEAD;
+        }
+        if (nearHead) {
+            contested[contestedCount++] = static_cast<Direction>(d);
+        } else {
+            options[count++] = static_cast<Direction>(d);
+        }
+    }
+    if (count == 0) {
+        std::copy(contested, contested + contestedCount, options);
+        count = contestedCount;
+    }
+    if (count == 0) return s.direction;
+
+    if (targetDistance >= 0) {
+        Direction best = options[0];
+        int bestDistance = -1;
+        for (int i = 0; i < count; ++i) {
+            Point next = stepPoint(head, options[i]);
+            int distance = std::abs(next.x - target.x) + std::abs(next.y - target.y);
+            if (bestDistance < 0 || distance < bestDistance) {
+                best = options[i];
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+
+    bool straightSafe = false;
+    for (int i = 0; i < count; ++i) {
+        straightSafe = straightSafe || options[i] == s.direction;
+    }
+    if (straightSafe && rng.below(WANDER_TURN_ODDS) != 0) {
+        return s.direction;
+    }
+    return options[rng.below(static_cast<uint32_t>(count))];
+}
+
+ArenaReport runArena(const ArenaConfig& config) {
+    ArenaReport report;
+    report.threads = config.threads > 0
+        ? config.threads
+        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    ArenaEngine arena;
+    arena.reset(config.width, config.height, config.snakes,
+                config.food > 0 ? config.food : 2 * config.snakes, config.seed);
+
+    // One RNG per snake so bot choices do not depend on who plans them
+    std::vector<GameRng> botRngs;
+    for (int i = 0; i < arena.snakeCount(); ++i) {
+        botRngs.push_back(GameRng(config.seed ^ (0x9E3779B97F4A7C15ULL * (i + 1))));
+    }
+
+    int workers = std::min(report.threads, std::max(arena.snakeCount(), 1));
+    TickBarrier planned(workers);
+    TickBarrier resolved(workers);
+    bool running = config.ticks > 0;
+
+    // Every worker, the calling thread included, steers and plans its own
+    // contiguous slice of snakes; the calling thread then resolves alone
+    auto work = [&](int self) {
+        int begin = static_cast<int>(static_cast<long long>(arena.snakeCount()) * self / workers);
+        int end = static_cast<int>(static_cast<long long>(arena.snakeCount()) * (self + 1) / workers);
+        for (;;) {
+            resolved.wait();
+            if (!running) return;
+            for (int i = begin; i < end; ++i) {
+                arena.steer(i, chooseArenaMove(arena, i, botRngs[i]));
+            }
+            arena.plan(begin, end);
+            planned.wait();
+            if (self == 0) return;  // The calling thread resolves, then re-enters
+        }
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; ++i) {
+        threads.push_back(std::thread(work, i));
+    }
+    while (running) {
+        work(0);
+        arena.resolve();
+        running = arena.tick() < config.ticks;
+    }
+    resolved.wait();  // Release the workers to see `running` is false
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    report.ticks = arena.tick();
+    report.alive = arena.aliveCount();
+    report.longest = 0;
+    for (int i = 0; i < arena.snakeCount(); ++i) {
+        if (arena.snake(i).alive) {
+            report.longest = std::max(report.longest, static_cast<int>(arena.snake(i).body.size()));
+        }
+    }
+    report.eaten = arena.foodEaten();
+    for (int i = 0; i < DEATH_KIND_COUNT; ++i) {
+        report.deaths[i] = arena.deaths(static_cast<ArenaDeath>(i));
+    }
+    report.checksum = arena.checksum();
+    return report;
+}
@@ -0,0 +1,164 @@
+// Many-snake arena simulation.
+//
+// ArenaEngine runs any number of snakes and food items on one shared
+// CellGrid. A tick has two phases:
+//
+//   plan     Each snake works out its next head cell and whether it eats,
+//            reading the board but writing only its own ArenaSnake. Ranges
+//            of snakes can be planned on different threads.
+//   resolve  Single-threaded, in snake id order. Planned heads and vacating
+//            tails go into a small open-addressing hash keyed by cell, so
+//            head-to-head and head-to-body collisions for all snakes cost
+//            O(snakes) rather than O(snakes x total length).
+//
+// All snakes move simultaneously. A head may enter a tail cell that is
+// vacated this tick; two heads entering the same cell both die. Dead snakes
+// leave food behind and, if respawning is on, reappear elsewhere. Every
+// choice is driven by the seed, so a given seed and set of steer() calls
+// plays out identically however planning is split across threads.
+
+#ifndef SNAKE_ARENA_H
+#define SNAKE_ARENA_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "snake_engine.h"
+
+// How an arena snake died
+enum ArenaDeath {
+    DEATH_WALL,
+    DEATH_BODY,     // Ran into any snake's body, including its own
+    DEATH_HEAD_ON,  // Another head entered the same cell
+    DEATH_KIND_COUNT
+};
+
+struct ArenaSnake {
+    SnakeBody body;
+    Direction direction;
+    Direction requested;  // From steer(); applied on the next tick
+    int score;
+    bool alive;
+    int deadTicks;        // Ticks since death, for respawning
+
+    // Filled in by the plan phase
+    Point next;
+    bool moving;
+    bool eating;
+    bool hitWall;
+};
+
+class ArenaEngine {
+public:
+    static const int START_LENGTH = 3;
+    static const int RESPAWN_TICKS = 20;  // Ticks a dead snake waits before respawning
+    static const int DEAD_FOOD_STRIDE = 3;  // Every Nth segment of a dead snake becomes food
+
+    ArenaEngine();
+
+    // Clear the board and place `snakes` snakes and `food` food items
+    void reset(int width, int height, int snakes, int food, uint64_t seed);
+    void setRespawn(bool enabled) { respawn = enabled; }
+
+    // Direction snake `id` tries on the next tick; reversals are ignored
+    void steer(int id, Direction d);
+
+    // Plan snakes [begin, end). Safe to call concurrently for disjoint
+    // ranges; must not overlap resolve().
+    void plan(int begin, int end);
+    // Apply the planned moves for every snake
+    void resolve();
+    // plan() then resolve() for all snakes on the calling thread
+    void step();
+
+    int width() const { return boardWidth; }
+    int height() const { return boardHeight; }
+    int snakeCount() const { return static_cast<int>(snakes.size()); }
+    const ArenaSnake& snake(int id) const { return snakes[id]; }
+    CellKind cellAt(int x, int y) const { return static_cast<CellKind>(cellGrid.get(x, y)); }
+    bool inBounds(const Point& p) const {
+        return p.x >= 0 && p.x < boardWidth && p.y >= 0 && p.y < boardHeight;
+    }
+    long long tick() const { return tickCount; }
+    int aliveCount() const { return living; }
+    int foodCount() const { return foodItems; }
+    long long deaths(ArenaDeath kind) const { return deathCounts[kind]; }
+    long long foodEaten() const { return eaten; }
+    const CellGrid& grid() const { return cellGrid; }
+
+    // Hash of every snake's position and score, for checking determinism
+    uint64_t checksum() const;
+
+private:
+    // Open-addressing table of cells touched this tick, reset by bumping
+    // `generation` instead of clearing
+    struct CellSlot {
+        int cell;
+        unsigned generation;
+        int heads;       // Planned heads entering the cell
+        bool vacating;   // A tail leaves the cell this tick
+    };
+
+    CellGrid cellGrid;
+    std::vector<ArenaSnake> snakes;
+    std::vector<CellSlot> table;
+    std::vector<std::pair<int, ArenaDeath> > dying;  // Scratch for resolve()
+    unsigned generation;
+    GameRng rng;
+    int boardWidth;
+    int boardHeight;
+    int targetFood;
+    int foodItems;
+    int living;
+    bool respawn;
+    long long tickCount;
+    long long deathCounts[DEATH_KIND_COUNT];
+    long long eaten;
+
+    CellSlot& slotFor(int cell);
+    bool place(ArenaSnake& s);
+    void kill(ArenaSnake& s, ArenaDeath cause);
+    void spawnFood();
+};
+
+// Choose a direction for snake `id`: the safe move that best closes on food
+// within a few cells, otherwise an occasional random turn. Only reads the
+// arena, so bots for different snakes may run concurrently.
+Direction chooseArenaMove(const ArenaEngine& arena, int id, GameRng& rng);
+
+struct ArenaConfig {
+    int snakes;
+    int food;          // 0 = two per snake
+    int width;
+    int height;
+    long long ticks;
+    uint64_t seed;
+    int threads;       // 0 = one per hardware thread
+
+    ArenaConfig()
+        : snakes(200),
+          food(0),
+          width(256),
+          height(256),
+          ticks(10000),
+          seed(1),
+          threads(0) {
+    }
+};
+
+struct ArenaReport {
+    long long ticks;
+    int threads;
+    double seconds;
+    int alive;
+    int longest;
+    long long eaten;
+    long long deaths[DEATH_KIND_COUNT];
+    uint64_t checksum;
+};
+
+// Run a bot-only arena with planning spread over worker threads
+ArenaReport runArena(const ArenaConfig& config);
+
+#endif // SNAKE_ARENA_H
@@ -0,0 +1,182 @@
+#include "snake_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int CACHE_LINE = 64;
+
+// A worker's remaining games as [begin, end) packed into one atomic word:
+// begin in the high 32 bits, end in the low 32 bits. The owner takes from
+// the front and thieves take the back half, both with a single CAS.
+struct WorkRange {
+    std::atomic<uint64_t> bounds;
+    char pad[CACHE_LINE - sizeof(std::atomic<uint64_t>)];  // Keep workers off each other's lines
+};
+
+uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+
+bool takeFront(WorkRange& range, uint32_t& index) {
+    uint64_t bounds = range.bounds.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t begin = static_cast<uint32_t>(bounds >> 32);
+        uint32_t end = static_cast<uint32_t>(bounds);
+        if (begin >= end) {
+            return false;
+        }
+        if (range.bounds.compare_exchange_weak(bounds, packRange(begin + 1, end),
+                                               std::memory_order_acq_rel)) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+// Move the back half of a victim's range into `own`, which must be empty
+bool stealHalf(WorkRange& victim, WorkRange& own) {
+    uint64_t bounds = victim.bounds.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t begin = static_cast<uint32_t>(bounds >> 32);
+        uint32_t end = static_cast<uint32_t>(bounds);
+        if (begin >= end) {
+            return false;
+        }
+        uint32_t mid = begin + (end - begin) / 2;
+        if (victim.bounds.compare_exchange_weak(bounds, packRange(begin, mid),
+                                                std::memory_order_acq_rel)) {
+            own.bounds.store(packRange(mid, end), std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+struct WorkerResult {
+    BatchStats stats;
+    long long steals;
+};
+
+void playGames(const BatchConfig& config, long long maxTicks, int self,
+               std::vector<WorkRange>& ranges, WorkerResult& result) {
+    BatchStats stats;
+    long long steals = 0;
+    SnakeEngine engine;
+    int workers = static_cast<int>(ranges.size());
+
+    for (;;) {
+        uint32_t index;
+        if (!takeFront(ranges[self], index)) {
+            bool stole = false;
+            for (int i = 1; i < workers && !stole; ++i) {
+                stole = stealHalf(ranges[(self + i) % workers], ranges[self]);
+            }
+            if (!stole) break;
+            steals++;
+            continue;
+        }
+
+        uint64_t seed = batchGameSeed(config.baseSeed, index);
+        engine.reset(config.width, config.height, seed);
+        std::unique_ptr<SnakePolicy> policy = createPolicy(config.policy, ~seed, config.budgetMicros);
+        policy->newGame(engine);
+
+        long long ticks = 0;
+        while (!engine.isOver() && ticks < maxTicks) {
+            engine.step(policy->choose(engine));
+            ticks++;
+        }
+        stats.add(engine.score(), static_cast<int>(engine.body().size()), ticks, engine.reason());
+    }
+
+    result.stats = stats;
+    result.steals = steals;
+}
+
+} // namespace
+
+BatchStats::BatchStats()
+    : games(0),
+      ticks(0),
+      scoreSum(0),
+      lengthSum(0),
+      minScore(0),
+      maxScore(0) {
+    std::fill(endCounts, endCounts + 4, 0LL);
+}
+
+void BatchStats::add(int score, int length, long long gameTicks, EndReason reason) {
+    minScore = games == 0 ? score : std::min(minScore, score);
+    maxScore = games == 0 ? score : std::max(maxScore, score);
+    games++;
+    ticks += gameTicks;
+    scoreSum += score;
+    lengthSum += length;
+    endCounts[reason]++;
+}
+
+void BatchStats::merge(const BatchStats& other) {
+    if (other.games == 0) return;
+    minScore = games == 0 ? other.minScore : std::min(minScore, other.minScore);
+    maxScore = games == 0 ? other.maxScore : std::max(maxScore, other.maxScore);
+    games += other.games;
+    ticks += other.ticks;
+    scoreSum += other.scoreSum;
+    lengthSum += other.lengthSum;
+    for (int i = 0; i < 4; ++i) {
+        endCounts[i] += other.endCounts[i];
+    }
+}
+
+uint64_t batchGameSeed(uint64_t baseSeed, long long index) {
+    // One splitmix64 step apart per game so neighbouring seeds decorrelate
+    GameRng mixer(baseSeed + static_cast<uint64_t>(index) * 0x9E3779B97F4A7C15ULL);
+    return mixer.next();
+}
+
+BatchReport runBatch(const BatchConfig& config) {
+    BatchReport report;
+    report.threads = config.threads > 0
+        ? config.threads
+        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    report.steals = 0;
+
+    // Ranges are 32-bit; larger batches are truncated
+    uint32_t games = static_cast<uint32_t>(std::min<long long>(std::max(config.games, 0LL), 0xFFFFFFFFLL));
+    long long maxTicks = config.maxTicks > 0
+        ? config.maxTicks
+        : 100LL * std::max(config.width, 1) * std::max(config.height, 1);
+
+    // Deal contiguous slices; stealing evens out the long games later
+    int workers = report.threads;
+    std::vector<WorkRange> ranges(workers);
+    for (int i = 0; i < workers; ++i) {
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(games) * i / workers);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(games) * (i + 1) / workers);
+        ranges[i].bounds.store(packRange(begin, end));
+    }
+
+    std::vector<WorkerResult> results(workers);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; ++i) {
+        threads.push_back(std::thread(playGames, std::cref(config), maxTicks, i,
+                                      std::ref(ranges), std::ref(results[i])));
+    }
+    playGames(config, maxTicks, 0, ranges, results[0]);
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int i = 0; i < workers; ++i) {
+        report.totals.merge(results[i].stats);
+        report.steals += results[i].steals;
+    }
+    return report;
+}
@@ -0,0 +1,67 @@
+// Parallel batch simulation of headless games.
+//
+// runBatch() plays many seeded games with a SnakePolicy across a pool of
+// worker threads. Games are handed out through per-worker index ranges with
+// work stealing, since game lengths vary widely. Each worker aggregates its
+// own BatchStats and the totals are merged after the workers join, so no
+// locks are taken while games run. Game i always uses the same seed, so a
+// batch's results do not depend on the thread count.
+
+#ifndef SNAKE_BATCH_H
+#define SNAKE_BATCH_H
+
+#include <cstdint>
+
+#include "snake_engine.h"
+#include "snake_policy.h"
+
+struct BatchConfig {
+    long long games;
+    int width;
+    int height;
+    uint64_t baseSeed;
+    int threads;          // 0 = one per hardware thread
+    long long maxTicks;   // Per-game cap; 0 = 100 ticks per board cell
+    PolicyKind policy;
+    int budgetMicros;     // Per-tick planning budget; 0 = none, keeps results reproducible
+
+    BatchConfig()
+        : games(1000),
+          width(DEFAULT_WIDTH),
+          height(DEFAULT_HEIGHT),
+          baseSeed(1),
+          threads(0),
+          maxTicks(0),
+          policy(POLICY_GREEDY),
+          budgetMicros(0) {
+    }
+};
+
+// Aggregated outcome of a set of games
+struct BatchStats {
+    long long games;
+    long long ticks;
+    long long scoreSum;
+    long long lengthSum;
+    int minScore;
+    int maxScore;
+    long long endCounts[4];  // Indexed by EndReason; END_NONE = hit maxTicks
+
+    BatchStats();
+    void add(int score, int length, long long gameTicks, EndReason reason);
+    void merge(const BatchStats& other);
+};
+
+struct BatchReport {
+    BatchStats totals;
+    int threads;
+    double seconds;
+    long long steals;  // Ranges taken from another worker
+};
+
+// Seed used for game `index` of a batch
+uint64_t batchGameSeed(uint64_t baseSeed, long long index);
+
+BatchReport runBatch(const BatchConfig& config);
+
+#endif // SNAKE_BATCH_H
@@ -0,0 +1,473 @@
+// Benchmarks for the engine and renderer hot paths.
+//
+// Times SnakeEngine::step(), food respawning, bitboard flood fills and frame
+// composition at several board sizes and snake fill levels. Frames go to a
+// null sink; only their size is kept. Reports ns per operation, bytes per frame and heap
+// allocations per operation.
+//
+// With --check it instead runs a deterministic self-check of the formats and
+// undo paths that claim exact reproduction: seeking a recording through its
+// keyframes must give the same state as replaying it from tick 0, and
+// RewindBuffer::rewind(n) the same state as re-simulating to tick - n.
+//
+// Usage: snake_bench [scale]   (scale multiplies iteration counts, default 1)
+//        snake_bench --check [FILE]   (FILE is the scratch recording,
+//                                      default snake_check.rec)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "snake_engine.h"
+#include "snake_policy.h"
+#include "snake_recording.h"
+#include "snake_render.h"
+#include "snake_rewind.h"
+
+// Count every heap allocation made by the process
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) std::abort();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int BOARD_SIZES[][2] = {{40, 20}, {100, 50}, {400, 200}};
+const double FILL_LEVELS[] = {0.10, 0.50, 0.95};
+const int RELOAD_INTERVAL = 256;  // Steps between restoring the target fill
+
+// Self-check setup: autopilot games long enough for several keyframes
+const int CHECK_BOARDS[][2] = {{24, 16}, {40, 20}};
+const uint64_t CHECK_SEED = 20261016;
+const long long CHECK_MAX_TICKS = 40000;
+const int CHECK_SEEKS = 64;          // Random seek targets per recorded game
+const size_t CHECK_REWIND_TICKS = 1000;  // RewindBuffer capacity
+const int CHECK_REWINDS = 40;        // Rewinds compared against a re-simulation
+
+// Direction to leave each cell along a Hamiltonian cycle: serpentine rows
+// from column 1, returning up column 0. Requires an even height.
+Direction cycleDirection(int x, int y, int width, int height) {
+    if (x == 0) return y == 0 ? RIGHT : UP;
+    if (y % 2 == 0) return x < width - 1 ? RIGHT : DOWN;
+    if (x > 1) return LEFT;
+    return y == height - 1 ? LEFT : DOWN;
+}
+
+// A game with `length` segments laid along the cycle, heading along it.
+// Following the cycle from here never collides.
+EngineState makeState(int width, int height, int length) {
+    std::vector<Point> order;
+    order.reserve(static_cast<size_t>(width) * height);
+    Point p = {0, 0};
+    for (int i = 0; i < width * height; ++i) {
+        order.push_back(p);
+        p = stepPoint(p, cycleDirection(p.x, p.y, width, height));
+    }
+
+    EngineState state;
+    state.width = width;
+    state.height = height;
+    for (int i = 0; i < length; ++i) {
+        state.body.pushHead(order[i]);
+    }
+    Point head = state.body.head();
+    state.direction = cycleDirection(head.x, head.y, width, height);
+    state.food = order[(length + static_cast<int>(order.size())) / 2 % order.size()];
+    state.endReason = END_NONE;
+    state.score = length - 3;
+    state.speed = 50;
+    state.seed = 12345;
+    state.rngState = 12345;
+    return state;
+}
+
+struct Result {
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+void report(const char* name, int width, int height, double fill, const Result& r) {
+    printf("%-14s %4dx%-4d %4.0f%% %12.1f %12.2f %14.1f\n",
+           name, width, height, fill * 100, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+}
+
+double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+Direction nextMove(const SnakeEngine& engine) {
+    Point head = engine.head();
+    return cycleDirection(head.x, head.y, engine.width(), engine.height());
+}
+
+// step() along the cycle, restoring the fill level every RELOAD_INTERVAL
+Result benchStep(SnakeEngine& engine, const EngineState& start, long iterations) {
+    double ns = 0;
+    unsigned long long allocs = 0;
+    long done = 0;
+    while (done < iterations) {
+        engine.loadState(start);
+        long batch = std::min<long>(RELOAD_INTERVAL, iterations - done);
+        unsigned long long before = allocationCount;
+        Clock::time_point t0 = Clock::now();
+        for (long i = 0; i < batch && !engine.isOver(); ++i) {
+            engine.step(nextMove(engine));
+        }
+        ns += elapsedNs(t0);
+        allocs += allocationCount - before;
+        done += batch;
+    }
+    Result r = {ns / iterations, static_cast<double>(allocs) / iterations, 0};
+    return r;
+}
+
+Result benchSpawnFood(SnakeEngine& engine, const EngineState& start, long iterations) {
+    engine.loadState(start);
+    unsigned long long before = allocationCount;
+    Clock::time_point t0 = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        engine.respawnFood();
+    }
+    Result r = {elapsedNs(t0) / iterations,
+                static_cast<double>(allocationCount - before) / iterations, 0};
+    return r;
+}
+
+// Free cells reachable from the head, on the engine's bitboard
+Result benchReach(SnakeEngine& engine, const EngineState& start, long iterations,
+                  unsigned long long& sink) {
+    engine.loadState(start);
+    const Bitboard& blocked = engine.bodyBits();
+    Bitboard region;
+    region.reset(blocked.width(), blocked.height());
+    Point head = engine.head();
+    unsigned long long cells = 0;
+    unsigned long long before = allocationCount;
+    Clock::time_point t0 = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        cells += bitboard::reachableFrom(blocked, head.x, head.y, region);
+    }
+    Result r = {elapsedNs(t0) / iterations,
+                static_cast<double>(allocationCount - before) / iterations, 0};
+    sink += cells;
+    return r;
+}
+
+// The same on the compile-time sized default board
+Result benchReachFixed(SnakeEngine& engine, const EngineState& start, long iterations,
+                       unsigned long long& sink) {
+    engine.loadState(start);
+    DefaultBitboard blocked;
+    DefaultBitboard region;
+    blocked.load(engine.bodyBits());
+    Point head = engine.head();
+    unsigned long long cells = 0;
+    Clock::time_point t0 = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        cells += bitboard::reachableFrom(blocked, head.x, head.y, region);
+    }
+    Result r = {elapsedNs(t0) / iterations, 0, 0};
+    sink += cells;
+    return r;
+}
+
+// Full repaint every frame, the worst case for bytes and CPU
+Result benchRenderFull(SnakeEngine& engine, const EngineState& start, long iterations,
+                       unsigned long long& sink) {
+    engine.loadState(start);
+    FrameRenderer renderer;
+    renderer.compose(engine, false);  // Size the frame buffer outside the timing
+    unsigned long long bytes = 0;
+    unsigned long long before = allocationCount;
+    Clock::time_point t0 = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        renderer.invalidate();
+        renderer.compose(engine, false);
+        bytes += renderer.frame().size();
+    }
+    Result r = {elapsedNs(t0) / iterations,
+                static_cast<double>(allocationCount - before) / iterations,
+                static_cast<double>(bytes) / iterations};
+    sink += bytes;
+    return r;
+}
+
+// A steady-state game tick: step() followed by a delta frame
+Result benchTickDelta(SnakeEngine& engine, const EngineState& start, long iterations,
+                      unsigned long long& sink) {
+    FrameRenderer renderer;
+    engine.setChangeTracking(true);
+    double ns = 0;
+    unsigned long long bytes = 0;
+    unsigned long long allocs = 0;
+    long done = 0;
+    while (done < iterations) {
+        engine.loadState(start);
+        renderer.invalidate();
+        renderer.compose(engine, false);
+        long batch = std::min<long>(RELOAD_INTERVAL, iterations - done);
+        unsigned long long before = allocationCount;
+        Clock::time_point t0 = Clock::now();
+        for (long i = 0; i < batch && !engine.isOver(); ++i) {
+            engine.step(nextMove(engine));
+            renderer.compose(engine, false);
+            bytes += renderer.frame().size();
+        }
+        ns += elapsedNs(t0);
+        allocs += allocationCount - before;
+        done += batch;
+    }
+    engine.setChangeTracking(false);
+    Result r = {ns / iterations, static_cast<double>(allocs) / iterations,
+                static_cast<double>(bytes) / iterations};
+    sink += bytes;
+    return r;
+}
+
+// Same game state, including the free-cell order later food depends on
+bool sameState(const EngineState& a, const EngineState& b) {
+    if (a.width != b.width || a.height != b.height || a.food != b.food ||
+        a.direction != b.direction || a.endReason != b.endReason || a.score != b.score ||
+        a.speed != b.speed || a.seed != b.seed || a.rngState != b.rngState ||
+        a.freeOrder != b.freeOrder || a.body.size() != b.body.size()) {
+        return false;
+    }
+    for (SnakeBody::Iterator i = a.body.begin(), j = b.body.begin(); i != a.body.end(); ++i, ++j) {
+        if (*i != *j) return false;
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::vector<unsigned char>& out) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    unsigned char buffer[1 << 16];
+    size_t got;
+    out.clear();
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        out.insert(out.end(), buffer, buffer + got);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+// Record seeded autopilot games, then compare the state at random ticks
+// reached by InputReplay::seek() (in random order, so both keyframe loads
+// and forward simulation are used) against a straight replay from tick 0
+bool checkSeek(const std::string& path) {
+    size_t gameCount = sizeof(CHECK_BOARDS) / sizeof(CHECK_BOARDS[0]);
+    std::vector<EngineState> finals(gameCount);
+    InputRecorder recorder;
+    if (!recorder.open(path)) {
+        fprintf(stderr, "check: cannot write %s\n", path.c_str());
+        return false;
+    }
+    SnakeEngine engine;
+    for (size_t g = 0; g < gameCount; ++g) {
+        uint64_t seed = CHECK_SEED + g;
+        engine.reset(CHECK_BOARDS[g][0], CHECK_BOARDS[g][1], seed);
+        std::unique_ptr<SnakePolicy> policy = createPolicy(POLICY_AUTOPILOT, seed);
+        policy->newGame(engine);
+        recorder.beginGame(engine.width(), engine.height(), seed);
+        for (long long t = 0; t < CHECK_MAX_TICKS && !engine.isOver(); ++t) {
+            Direction d = policy->choose(engine);
+            recorder.record(d, engine);
+            engine.step(d);
+        }
+        engine.saveState(finals[g], true);
+    }
+    recorder.close();
+
+    std::vector<unsigned char> data;
+    InputReplay straight;
+    InputReplay seeking;
+    if (!readFile(path, data) || !straight.open(data.data(), data.size()) ||
+        !seeking.open(data.data(), data.size())) {
+        fprintf(stderr, "check: cannot read back %s\n", path.c_str());
+        return false;
+    }
+    remove(path.c_str());
+
+    GameRng rng(CHECK_SEED);
+    SnakeEngine seeker;
+    EngineState actual;
+    bool ok = true;
+    for (size_t g = 0; g < gameCount; ++g) {
+        int width, height;
+        uint64_t seed;
+        straight.nextGame(width, height, seed);
+        seeking.nextGame(width, height, seed);
+        long long ticks = straight.gameTicks();
+        size_t keyframes = straight.games()[g].keyframeTicks.size();
+
+        std::vector<long long> targets(CHECK_SEEKS);
+        for (int i = 0; i < CHECK_SEEKS; ++i) {
+            targets[i] = rng.below(static_cast<uint32_t>(ticks + 1));
+        }
+        std::vector<long long> sorted(targets);
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        // Straight replay, keeping the state at every target tick
+        std::vector<EngineState> states(sorted.size());
+        engine.reset(width, height, seed);
+        size_t next = 0;
+        Direction d;
+        for (long long t = 0; ; ++t) {
+            if (next < sorted.size() && sorted[next] == t) {
+                engine.saveState(states[next++], true);
+            }
+            if (!straight.nextInput(d)) break;
+            engine.step(d);
+        }
+        engine.saveState(actual, true);
+        if (!sameState(actual, finals[g])) {
+            fprintf(stderr, "check: game %zu replays to a different end state\n", g + 1);
+            ok = false;
+        }
+
+        seeker.reset(width, height, seed);
+        for (int i = 0; i < CHECK_SEEKS; ++i) {
+            size_t k = std::lower_bound(sorted.begin(), sorted.end(), targets[i]) - sorted.begin();
+            if (!seeking.seek(seeker, targets[i])) {
+                fprintf(stderr, "check: game %zu cannot seek to tick %lld\n", g + 1, targets[i]);
+                ok = false;
+                continue;
+            }
+            seeker.saveState(actual, true);
+            if (!sameState(actual, states[k])) {
+                fprintf(stderr, "check: game %zu differs after seeking to tick %lld\n", g + 1, targets[i]);
+                ok = false;
+            }
+        }
+        printf("check seek:   game %zu, %dx%d, %lld ticks, %zu keyframes, %d seeks\n",
+               g + 1, width, height, ticks, keyframes, CHECK_SEEKS);
+    }
+    return ok;
+}
+
+// Play a seeded autopilot game through a RewindBuffer, rewinding a random
+// number of ticks now and then, and compare each rewound state against a
+// fresh engine re-simulated from tick 0 with the surviving inputs
+bool checkRewind() {
+    int width = CHECK_BOARDS[0][0];
+    int height = CHECK_BOARDS[0][1];
+    uint64_t seed = CHECK_SEED;
+    SnakeEngine engine;
+    SnakeEngine fresh;
+    engine.reset(width, height, seed);
+    std::unique_ptr<SnakePolicy> policy = createPolicy(POLICY_AUTOPILOT, seed);
+    policy->newGame(engine);
+    RewindBuffer buffer(CHECK_REWIND_TICKS);
+    GameRng rng(~CHECK_SEED);
+    std::vector<Direction> inputs;
+    EngineState expected;
+    EngineState actual;
+    bool ok = true;
+    int rewinds = 0;
+
+    while (rewinds < CHECK_REWINDS && !engine.isOver()) {
+        long long burst = 1 + rng.below(3 * static_cast<uint32_t>(CHECK_REWIND_TICKS));
+        for (long long i = 0; i < burst && !engine.isOver(); ++i) {
+            Direction d = policy->choose(engine);
+            inputs.push_back(d);
+            buffer.step(engine, d);
+        }
+        size_t back = 1 + rng.below(static_cast<uint32_t>(CHECK_REWIND_TICKS + 64));
+        size_t taken = buffer.rewind(engine, back);
+        inputs.resize(inputs.size() - taken);
+        policy->newGame(engine);
+        rewinds++;
+
+        fresh.reset(width, height, seed);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            fresh.step(inputs[i]);
+        }
+        engine.saveState(actual, true);
+        fresh.saveState(expected, true);
+        if (!sameState(actual, expected)) {
+            fprintf(stderr, "check: rewinding %zu ticks to tick %zu differs from a re-simulation\n",
+                    taken, inputs.size());
+            ok = false;
+        }
+    }
+    printf("check rewind: %dx%d, %d rewinds, reached tick %zu\n", width, height, rewinds, inputs.size());
+    return ok;
+}
+
+int runChecks(const std::string& path) {
+    bool ok = checkSeek(path);
+    ok = checkRewind() && ok;
+    printf("%s\n", ok ? "check passed" : "check FAILED");
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        return runChecks(argc > 2 ? argv[2] : "snake_check.rec");
+    }
+    double scale = argc > 1 ? atof(argv[1]) : 1.0;
+    if (scale <= 0) {
+        fprintf(stderr, "Usage: %s [scale] | --check [FILE]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned long long sink = 0;
+    printf("%-14s %9s %5s %12s %12s %14s\n",
+           "benchmark", "board", "fill", "ns/op", "allocs/op", "bytes/frame");
+
+    for (size_t b = 0; b < sizeof(BOARD_SIZES) / sizeof(BOARD_SIZES[0]); ++b) {
+        int width = BOARD_SIZES[b][0];
+        int height = BOARD_SIZES[b][1];
+        int cells = width * height;
+        long fastIterations = static_cast<long>(200000 * scale);
+        long frameIterations = std::max(20L, static_cast<long>(4e6 * scale / cells));
+
+        for (size_t f = 0; f < sizeof(FILL_LEVELS) / sizeof(FILL_LEVELS[0]); ++f) {
+            double fill = FILL_LEVELS[f];
+            int length = std::max(3, static_cast<int>(cells * fill));
+            EngineState start = makeState(width, height, length);
+            SnakeEngine engine;
+
+            report("step", width, height, fill, benchStep(engine, start, fastIterations));
+            report("spawnFood", width, height, fill, benchSpawnFood(engine, start, fastIterations));
+            report("reach", width, height, fill, benchReach(engine, start, frameIterations * 10, sink));
+            if (width == DEFAULT_WIDTH && height == DEFAULT_HEIGHT) {
+                report("reach-fixed", width, height, fill,
+                       benchReachFixed(engine, start, frameIterations * 10, sink));
+            }
+            report("render-full", width, height, fill,
+                   benchRenderFull(engine, start, frameIterations, sink));
+            report("tick+delta", width, height, fill,
+                   benchTickDelta(engine, start, fastIterations, sink));
+        }
+    }
+
+    // Keep the composed frames and fill counts observable so they are not optimised away
+    printf("\n(null sink received %llu bytes)\n", sink);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "snake_bitboard.h"
+
+#include <algorithm>
+
+Bitboard::Bitboard()
+    : boardWidth(0),
+      boardHeight(0),
+      wordsPerRow(0) {
+}
+
+void Bitboard::reset(int width, int height) {
+    boardWidth = width;
+    boardHeight = height;
+    wordsPerRow = (width + 63) >> 6;
+    words.assign(static_cast<size_t>(wordsPerRow) * height, 0);
+}
+
+void Bitboard::clearAll() {
+    std::fill(words.begin(), words.end(), 0);
+}
+
+int Bitboard::count() const {
+    int total = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+        total += bitboard::popcount(words[i]);
+    }
+    return total;
+}
@@ -0,0 +1,228 @@
+// One-bit-per-cell boards and word-parallel flood fill.
+//
+// Bitboard stores a board row-major, each row padded to whole 64-bit words
+// with bit x%64 of word x/64 holding column x. Flood fills work a row at a
+// time: a row takes in the bits of the rows above and below, then spreads
+// them along its own runs of open cells with a handful of shifts and masks,
+// so one pass handles 64 cells per operation with no per-cell branches.
+// Passes sweep down and up the board until nothing changes.
+//
+// FixedBitboard<W, H> is the same for a size known at compile time (W up to
+// 64, one word per row), so loops have constant bounds and no padding
+// masks. snake_engine.h defines DefaultBitboard for the default board.
+
+#ifndef SNAKE_BITBOARD_H
+#define SNAKE_BITBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bitboard {
+
+inline int popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Spread `seeds` through the runs of `open` bits that contain them, in both
+// directions. `seeds` must be a subset of `open`. Towards the high bits,
+// adding the seeds carries through the rest of each run and clears it;
+// towards the low bits there is no carry to borrow, so it uses a
+// Kogge-Stone fill (six shift steps).
+inline uint64_t fillRuns(uint64_t seeds, uint64_t open) {
+    uint64_t up = (open & ~(open + seeds)) | seeds;
+    uint64_t down = seeds;
+    uint64_t downOpen = open;
+    for (int shift = 1; shift < 64; shift *= 2) {
+        down |= downOpen & (down >> shift);
+        downOpen &= downOpen >> shift;
+    }
+    return up | down;
+}
+
+// Open bits of the `word`th word in a row of `width` cells
+inline uint64_t rowMask(int width, int word) {
+    int bits = width - word * 64;
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+} // namespace bitboard
+
+class Bitboard {
+public:
+    Bitboard();
+
+    // Size the board and clear every cell
+    void reset(int width, int height);
+
+    int width() const { return boardWidth; }
+    int height() const { return boardHeight; }
+    int rowWords() const { return wordsPerRow; }
+
+    bool test(int x, int y) const {
+        return (words[wordIndex(x, y)] >> (x & 63)) & 1;
+    }
+    void set(int x, int y) { words[wordIndex(x, y)] |= 1ULL << (x & 63); }
+    void clear(int x, int y) { words[wordIndex(x, y)] &= ~(1ULL << (x & 63)); }
+    void clearAll();
+    int count() const;
+
+    uint64_t* row(int y) { return &words[static_cast<size_t>(y) * wordsPerRow]; }
+    const uint64_t* row(int y) const { return &words[static_cast<size_t>(y) * wordsPerRow]; }
+    uint64_t rowMask(int word) const { return bitboard::rowMask(boardWidth, word); }
+
+private:
+    std::vector<uint64_t> words;
+    int boardWidth;
+    int boardHeight;
+    int wordsPerRow;
+
+    size_t wordIndex(int x, int y) const {
+        return static_cast<size_t>(y) * wordsPerRow + (x >> 6);
+    }
+};
+
+template <int W, int H>
+class FixedBitboard {
+public:
+    static_assert(W >= 1 && W <= 64 && H >= 1, "FixedBitboard holds one word per row");
+
+    FixedBitboard() { clearAll(); }
+
+    int width() const { return W; }
+    int height() const { return H; }
+    int rowWords() const { return 1; }
+
+    bool test(int x, int y) const { return (rows[y] >> x) & 1; }
+    void set(int x, int y) { rows[y] |= 1ULL << x; }
+    void clear(int x, int y) { rows[y] &= ~(1ULL << x); }
+    void clearAll() {
+        for (int y = 0; y < H; ++y) rows[y] = 0;
+    }
+    int count() const {
+        int total = 0;
+        for (int y = 0; y < H; ++y) total += bitboard::popcount(rows[y]);
+        return total;
+    }
+
+    uint64_t* row(int y) { return &rows[y]; }
+    const uint64_t* row(int y) const { return &rows[y]; }
+    uint64_t rowMask(int) const { return bitboard::rowMask(W, 0); }
+
+    // Copy a runtime board of the same size; false if the sizes differ
+    bool load(const Bitboard& other) {
+        if (other.width() != W || other.height() != H) return false;
+        for (int y = 0; y < H; ++y) rows[y] = other.row(y)[0];
+        return true;
+    }
+
+private:
+    uint64_t rows[H];
+};
+
+namespace bitboard {
+
+// One flood fill step for row `y`: take in the region's bits from the rows
+// above and below, spread them along the row's open runs and, for rows
+// wider than a word, carry them across word boundaries both ways. Returns
+// true if the row gained cells.
+template <class Board>
+bool growRow(const Board& blocked, Board& region, int y) {
+    const int words = blocked.rowWords();
+    uint64_t* r = region.row(y);
+    const uint64_t* b = blocked.row(y);
+    const uint64_t* above = y > 0 ? region.row(y - 1) : nullptr;
+    const uint64_t* below = y < blocked.height() - 1 ? region.row(y + 1) : nullptr;
+    bool changed = false;
+    for (int k = 0; k < words; ++k) {
+        uint64_t open = ~b[k] & region.rowMask(k);
+        uint64_t seeds = r[k];
+        if (above) seeds |= above[k];
+        if (below) seeds |= below[k];
+        seeds &= open;
+        if ((seeds & ~r[k]) == 0) continue;  // Nothing new; the word is already whole runs
+        r[k] = fillRuns(seeds, open);
+        changed = true;
+    }
+    for (int k = 1; k < words; ++k) {
+        uint64_t open = ~b[k] & region.rowMask(k);
+        uint64_t carry = (r[k - 1] >> 63) & open & 1;
+        if (carry & ~r[k]) {
+            r[k] = fillRuns(r[k] | carry, open);
+            changed = true;
+        }
+    }
+    for (int k = words - 2; k >= 0; --k) {
+        uint64_t open = ~b[k] & region.rowMask(k);
+        uint64_t carry = ((r[k + 1] & 1) << 63) & open;
+        if (carry & ~r[k]) {
+            r[k] = fillRuns(r[k] | carry, open);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Grow `region` into every cell that is not in `blocked` and is connected
+// to it. Seeds on blocked cells are dropped. Returns the region's size.
+template <class Board>
+int floodFill(const Board& blocked, Board& region) {
+    const int height = blocked.height();
+    const int words = blocked.rowWords();
+    // Spread the seeds along their own runs first, so every region word is
+    // made of whole runs and growRow() can skip words that gain nothing
+    for (int y = 0; y < height; ++y) {
+        uint64_t* r = region.row(y);
+        const uint64_t* b = blocked.row(y);
+        for (int k = 0; k < words; ++k) {
+            if (r[k] == 0) continue;
+            uint64_t open = ~b[k] & region.rowMask(k);
+            r[k] = fillRuns(r[k] & open, open);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int y = 0; y < height; ++y) {
+            changed |= growRow(blocked, region, y);
+        }
+        for (int y = height - 2; y >= 0; --y) {
+            changed |= growRow(blocked, region, y);
+        }
+    }
+    return region.count();
+}
+
+// Free cells reachable from (x, y) through cells not in `blocked`. The start
+// cell itself may be blocked (e.g. the head) and counts only if it is free.
+// `region` is scratch and is left holding the reachable cells.
+template <class Board>
+int reachableFrom(const Board& blocked, int x, int y, Board& region) {
+    region.clearAll();
+    if (x < 0 || x >= blocked.width() || y < 0 || y >= blocked.height()) return 0;
+    region.set(x, y);
+    if (x > 0) region.set(x - 1, y);
+    if (x < blocked.width() - 1) region.set(x + 1, y);
+    if (y > 0) region.set(x, y - 1);
+    if (y < blocked.height() - 1) region.set(x, y + 1);
+    return floodFill(blocked, region);
+}
+
+// True if a path of free cells leads from (fromX, fromY) to (toX, toY)
+template <class Board>
+bool reachable(const Board& blocked, int fromX, int fromY, int toX, int toY, Board& region) {
+    reachableFrom(blocked, fromX, fromY, region);
+    return region.test(toX, toY);
+}
+
+} // namespace bitboard
+
+#endif // SNAKE_BITBOARD_H
@@ -0,0 +1,178 @@
+#include "snake_engine.h"
+
+#include <algorithm>
+
+namespace {
+
+// Direction from `from` to the neighbouring point `to`, NONE if not adjacent
+Direction directionBetween(const Point& from, const Point& to) {
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    if (dy == 0 && dx == 1) return RIGHT;
+    if (dy == 0 && dx == -1) return LEFT;
+    if (dx == 0 && dy == 1) return DOWN;
+    if (dx == 0 && dy == -1) return UP;
+    return NONE;
+}
+
+} // namespace
+
+SnakeBody::Iterator& SnakeBody::Iterator::operator++() {
+    // Step back from segment `remaining - 1` across the link that led to it
+    if (--remaining > 0) {
+        pos = stepPoint(pos, reverseOf(body->link(remaining - 1)));
+    }
+    return *this;
+}
+
+SnakeBody::SnakeBody()
+    : ring(1, 0),
+      first(0),
+      count(0) {
+    headPos.x = headPos.y = 0;
+    tailPos = headPos;
+}
+
+void SnakeBody::clear() {
+    first = 0;
+    count = 0;
+}
+
+Direction SnakeBody::link(size_t index) const {
+    size_t at = (first + index) & mask();
+    return static_cast<Direction>((ring[at / LINKS_PER_WORD] >> (at % LINKS_PER_WORD * 2)) & 3);
+}
+
+void SnakeBody::setLink(size_t index, Direction d) {
+    size_t at = (first + index) & mask();
+    uint64_t& word = ring[at / LINKS_PER_WORD];
+    int shift = static_cast<int>(at % LINKS_PER_WORD * 2);
+    word = (word & ~(3ULL << shift)) | (static_cast<uint64_t>(d) << shift);
+}
+
+// Double the ring, moving the links to its start
+void SnakeBody::grow() {
+    std::vector<uint64_t> larger(ring.size() * 2, 0);
+    size_t links = count - 1;
+    for (size_t i = 0; i < links; ++i) {
+        larger[i / LINKS_PER_WORD] |= static_cast<uint64_t>(link(i)) << (i % LINKS_PER_WORD * 2);
+    }
+    ring.swap(larger);
+    first = 0;
+}
+
+bool SnakeBody::pushHead(const Point& p) {
+    if (count == 0) {
+        headPos = tailPos = p;
+        count = 1;
+        return true;
+    }
+    Direction d = directionBetween(headPos, p);
+    if (d == NONE) {
+        return false;
+    }
+    if (count - 1 == mask() + 1) {
+        grow();
+    }
+    setLink(count - 1, d);
+    headPos = p;
+    count++;
+    return true;
+}
+
+void SnakeBody::popTail() {
+    if (count == 0) return;
+    if (--count == 0) {
+        first = 0;
+        return;
+    }
+    tailPos = stepPoint(tailPos, link(0));
+    first = (first + 1) & mask();
+}
+
+void SnakeBody::popHead() {
+    if (count == 0) return;
+    if (--count == 0) {
+        first = 0;
+        return;
+    }
+    headPos = stepPoint(headPos, reverseOf(link(count - 1)));
+}
+
+bool SnakeBody::pushTail(const Point& p) {
+    if (count == 0) {
+        return pushHead(p);
+    }
+    Direction d = directionBetween(p, tailPos);
+    if (d == NONE) {
+        return false;
+    }
+    if (count - 1 == mask() + 1) {
+        grow();
+    }
+    first = (first - 1) & mask();
+    setLink(0, d);
+    tailPos = p;
+    count++;
+    return true;
+}
+
+SnakeBody::Iterator SnakeBody::begin() const {
+    Iterator it;
+    it.body = this;
+    it.pos = headPos;
+    it.remaining = count;
+    return it;
+}
+
+SnakeBody::Iterator SnakeBody::end() const {
+    Iterator it;
+    it.body = this;
+    it.pos = tailPos;
+    it.remaining = 0;
+    return it;
+}
+
+void SnakeBody::save(std::vector<uint64_t>& out) const {
+    size_t links = count > 0 ? count - 1 : 0;
+    out.assign(2 + (links + LINKS_PER_WORD - 1) / LINKS_PER_WORD, 0);
+    out[0] = static_cast<uint32_t>(tailPos.x) | (static_cast<uint64_t>(static_cast<uint32_t>(tailPos.y)) << 32);
+    out[1] = count;
+    if (first + links <= mask() + 1 && first % LINKS_PER_WORD == 0) {
+        // Links do not wrap and start on a word: copy whole words
+        std::copy(ring.begin() + first / LINKS_PER_WORD,
+                  ring.begin() + first / LINKS_PER_WORD + (out.size() - 2), out.begin() + 2);
+        if (links % LINKS_PER_WORD != 0) {
+            out.back() &= (1ULL << (links % LINKS_PER_WORD * 2)) - 1;
+        }
+        return;
+    }
+    for (size_t i = 0; i < links; ++i) {
+        out[2 + i / LINKS_PER_WORD] |= static_cast<uint64_t>(link(i)) << (i % LINKS_PER_WORD * 2);
+    }
+}
+
+bool SnakeBody::load(const uint64_t* data, size_t words) {
+    if (words < 2) return false;
+    uint64_t segments = data[1];
+    uint64_t links = segments > 0 ? segments - 1 : 0;
+    if (segments > static_cast<uint64_t>(MAX_BOARD_CELLS) ||
+        words != 2 + (links + LINKS_PER_WORD - 1) / LINKS_PER_WORD) {
+        return false;
+    }
+
+    size_t capacity = 1;
+    while (capacity * LINKS_PER_WORD < links) capacity *= 2;
+    ring.assign(capacity, 0);
+    std::copy(data + 2, data + words, ring.begin());
+    first = 0;
+    count = static_cast<size_t>(segments);
+
+    tailPos.x = static_cast<int>(static_cast<uint32_t>(data[0]));
+    tailPos.y = static_cast<int>(static_cast<uint32_t>(data[0] >> 32));
+    headPos = tailPos;
+    for (size_t i = 0; i < links; ++i) {
+        headPos = stepPoint(headPos, link(i));
+    }
+    return true;
+}
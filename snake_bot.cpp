@@ -0,0 +1,252 @@
+#include "snake_bot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t CELLS_OFFSET = 192;      // After the reply's cache line
+const int SPIN_CHECKS = 1 << 14;        // Lock-step: busy polls before yielding
+const int YIELD_MICROS = 1000;          // Then yield this long before sleeping
+const int SLEEP_MICROS = 100;           // Poll interval once the bot is slow
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "the bot region needs plain 64-bit atomics");
+static_assert(sizeof(BotRegion) == 136, "BotRegion layout is part of the bot protocol");
+
+} // namespace
+
+BotLink::BotLink()
+    : region(nullptr),
+      cells(nullptr),
+      mappedBytes(0),
+      lockstepMode(false),
+      quit(false),
+      frame(0),
+      gameFirstFrame(0),
+      gameNumber(0),
+      tick(0),
+      replyCount(0),
+      missedCount(0),
+      replyMicros(0)
+      #ifdef _WIN32
+      , mapping(nullptr)
+      #endif
+{
+    shownHead.x = shownHead.y = 0;
+    shownTail = shownFood = shownHead;
+}
+
+BotLink::~BotLink() {
+    close();
+}
+
+bool BotLink::open(const std::string& path, int maxCells, bool lockstep) {
+    close();
+    if (maxCells <= 0 || maxCells > MAX_BOT_CELLS) {
+        message = "board too large for the bot region";
+        return false;
+    }
+    size_t bytes = CELLS_OFFSET + static_cast<size_t>(maxCells);
+
+    #ifdef _WIN32
+    // A named, pagefile-backed mapping; `path` is its name
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                       0, static_cast<DWORD>(bytes), path.c_str());
+    if (handle == NULL) {
+        message = "cannot create mapping " + path;
+        return false;
+    }
+    void* base = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (base == NULL) {
+        CloseHandle(handle);
+        message = "cannot map " + path;
+        return false;
+    }
+    mapping = handle;
+    #else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        message = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    // Truncate to zero first so a stale region from an earlier run reads as
+    // empty rather than as a live game
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        message = "cannot size " + path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        message = "cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+    #endif
+
+    mappedBytes = bytes;
+    region = static_cast<BotRegion*>(base);
+    cells = static_cast<unsigned char*>(base) + CELLS_OFFSET;
+    lockstepMode = lockstep;
+    quit = false;
+
+    region->capacity = static_cast<uint32_t>(maxCells);
+    region->cellsOffset = CELLS_OFFSET;
+    region->lockstep = lockstep ? 1 : 0;
+    region->sequence.store(0, std::memory_order_relaxed);
+    region->reply.store(0, std::memory_order_relaxed);
+    region->version = BOT_VERSION;
+    // Magic last: a bot that sees it can trust the rest of the header
+    std::atomic_thread_fence(std::memory_order_release);
+    region->magic = BOT_MAGIC;
+    return true;
+}
+
+void BotLink::close() {
+    if (!region) return;
+    #ifdef _WIN32
+    UnmapViewOfFile(region);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+    #else
+    munmap(region, mappedBytes);
+    #endif
+    region = nullptr;
+    cells = nullptr;
+    mappedBytes = 0;
+}
+
+// Open the seqlock: readers that start now will retry
+void BotLink::beginWrite() {
+    uint64_t sequence = region->sequence.load(std::memory_order_relaxed);
+    region->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+// Fill in the fixed fields and close the seqlock
+void BotLink::endWrite(const SnakeEngine& engine) {
+    region->frame = ++frame;
+    region->game = gameNumber;
+    region->tick = tick;
+    region->width = engine.width();
+    region->height = engine.height();
+    region->headX = engine.head().x;
+    region->headY = engine.head().y;
+    region->foodX = engine.food().x;
+    region->foodY = engine.food().y;
+    region->score = engine.score();
+    region->length = static_cast<int32_t>(engine.body().size());
+    region->direction = engine.direction();
+    region->over = engine.reason();
+
+    uint64_t sequence = region->sequence.load(std::memory_order_relaxed);
+    region->sequence.store(sequence + 1, std::memory_order_release);
+
+    shownHead = engine.head();
+    shownTail = engine.body().tail();
+    shownFood = engine.food();
+    publishedAt = Clock::now();
+}
+
+void BotLink::writeCell(const SnakeEngine& engine, Point p) {
+    if (p.x < 0 || p.y < 0 || p.x >= engine.width() || p.y >= engine.height()) return;
+    cells[engine.cellIndex(p)] = static_cast<unsigned char>(engine.cellAt(p));
+}
+
+bool BotLink::newGame(const SnakeEngine& engine) {
+    if (!region) return false;
+    if (static_cast<long long>(engine.width()) * engine.height() > region->capacity) {
+        message = "board too large for the bot region";
+        return false;
+    }
+    beginWrite();
+    for (int y = 0; y < engine.height(); ++y) {
+        unsigned char* row = cells + static_cast<size_t>(y) * engine.width();
+        for (int x = 0; x < engine.width(); ++x) {
+            row[x] = static_cast<unsigned char>(engine.cellAt(x, y));
+        }
+    }
+    gameNumber++;
+    tick = 0;
+    gameFirstFrame = frame + 1;
+    endWrite(engine);
+    return true;
+}
+
+void BotLink::publish(const SnakeEngine& engine) {
+    if (!region) return;
+    beginWrite();
+    // One step changes at most the old and new head, tail and food cells
+    writeCell(engine, shownHead);
+    writeCell(engine, shownTail);
+    writeCell(engine, shownFood);
+    writeCell(engine, engine.head());
+    writeCell(engine, engine.body().tail());
+    writeCell(engine, engine.food());
+    tick++;
+    endWrite(engine);
+}
+
+// Decode the latest reply if it answers frame `minFrame` or later
+bool BotLink::takeReply(uint64_t minFrame, Direction& move) {
+    uint64_t reply = region->reply.load(std::memory_order_acquire);
+    if ((reply >> 8) < minFrame) return false;
+    int code = static_cast<int>(reply & 0xFF);
+    if (code == BOT_QUIT) {
+        quit = true;
+        move = NONE;
+    } else {
+        move = code <= NONE ? static_cast<Direction>(code) : NONE;
+    }
+    return true;
+}
+
+bool BotLink::nextMove(Direction& move, int timeoutMs) {
+    move = NONE;
+    if (!region) return false;
+    if (!lockstepMode) {
+        if (takeReply(gameFirstFrame, move)) replyCount++;
+        return true;
+    }
+
+    // Spin first: a bot on another core usually answers within microseconds.
+    // With one core, spinning only delays the bot, so go straight to yielding.
+    static const int spinChecks = std::thread::hardware_concurrency() > 1 ? SPIN_CHECKS : 0;
+    bool answered = false;
+    for (int i = 0; i < spinChecks && !answered; ++i) {
+        answered = takeReply(frame, move);
+    }
+    // Then yield the core, and sleep once the bot is clearly busy or absent
+    Clock::time_point deadline = publishedAt + std::chrono::milliseconds(timeoutMs);
+    Clock::time_point sleepFrom = Clock::now() + std::chrono::microseconds(YIELD_MICROS);
+    while (!answered) {
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            missedCount++;
+            return false;
+        }
+        if (now < sleepFrom) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(SLEEP_MICROS));
+        }
+        answered = takeReply(frame, move);
+    }
+    replyCount++;
+    replyMicros += std::chrono::duration<double, std::micro>(Clock::now() - publishedAt).count();
+    return true;
+}
+
+double BotLink::meanReplyMicros() const {
+    return replyCount > 0 && lockstepMode ? replyMicros / replyCount : 0;
+}
@@ -0,0 +1,138 @@
+// Shared-memory interface for out-of-process bots.
+//
+// BotLink maps a file (e.g. under /dev/shm) that the game and a bot process
+// both map. After every step the game publishes the state into it, and it
+// reads the bot's chosen Direction back out, so a bot needs no keystrokes
+// and no screen scraping and can answer within microseconds.
+//
+// Region layout (native byte order, offsets in bytes):
+//   0   u32 magic        BOT_MAGIC
+//   4   u32 version      BOT_VERSION
+//   8   u32 capacity     Board bytes available at cellsOffset
+//   12  u32 cellsOffset
+//   16  u32 lockstep     1 if the game waits for a reply to every frame
+//   64  u64 sequence     Seqlock: odd while the game is writing the state
+//   72  u64 frame        Number of this state, +1 per publish, never reused
+//   80  u32 game         Game number from 1; also bumped after a rewind
+//   84  u32 tick         Steps since the game (or rewind) began
+//   88  i32 width, height, headX, headY, foodX, foodY, score, length,
+//           direction (Direction), over (EndReason, 0 while playing)
+//   128 u64 reply        Written by the bot: (frame << 8) | move
+//   cellsOffset          width * height CellKind bytes, row-major
+//
+// To read the state, a bot loads `sequence`, retries while it is odd, copies
+// what it needs, then loads `sequence` again and retries if it changed. It
+// answers by storing `reply` with the frame it saw and a Direction, or
+// BOT_QUIT to end a headless run. In lock-step mode the game does not step
+// until the reply for the latest frame arrives (or a timeout passes);
+// otherwise it applies the newest reply at each tick.
+
+#ifndef SNAKE_BOT_H
+#define SNAKE_BOT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "snake_engine.h"
+
+const uint32_t BOT_MAGIC = 0x424B4E53;  // "SNKB"
+const uint32_t BOT_VERSION = 1;
+const int BOT_QUIT = 0xFF;               // Reply move that ends a headless run
+const int MAX_BOT_CELLS = 1 << 24;       // Largest board the region may hold
+
+struct BotRegion {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t cellsOffset;
+    uint32_t lockstep;
+    uint32_t reserved[11];
+
+    // Written by the game, guarded by `sequence`
+    std::atomic<uint64_t> sequence;
+    uint64_t frame;
+    uint32_t game;
+    uint32_t tick;
+    int32_t width;
+    int32_t height;
+    int32_t headX;
+    int32_t headY;
+    int32_t foodX;
+    int32_t foodY;
+    int32_t score;
+    int32_t length;
+    int32_t direction;
+    int32_t over;
+
+    // Written by the bot, on its own cache line
+    std::atomic<uint64_t> reply;
+};
+
+class BotLink {
+public:
+    BotLink();
+    ~BotLink();
+
+    // Create (or take over) the region at `path`, sized for boards of up to
+    // `maxCells` cells; false with error() set on failure
+    bool open(const std::string& path, int maxCells, bool lockstep);
+    const std::string& error() const { return message; }
+    bool isOpen() const { return region != nullptr; }
+    bool lockstep() const { return lockstepMode; }
+    void close();
+
+    // Publish the whole state of a new game, or of a game that jumped (a
+    // rewind); returns false if the board is larger than the region
+    bool newGame(const SnakeEngine& engine);
+    // Publish the state after exactly one step() since the last publish
+    void publish(const SnakeEngine& engine);
+
+    // The bot's move for the current state. In lock-step mode this waits up
+    // to `timeoutMs` for the reply to the latest frame and returns false if
+    // none came; otherwise it returns the newest reply this game, or NONE.
+    bool nextMove(Direction& move, int timeoutMs);
+    // The bot answered BOT_QUIT
+    bool quitRequested() const { return quit; }
+
+    long long replies() const { return replyCount; }
+    long long missedReplies() const { return missedCount; }
+    // Mean time from publishing a frame to seeing its reply, lock-step only
+    double meanReplyMicros() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    BotRegion* region;
+    unsigned char* cells;
+    size_t mappedBytes;
+    std::string message;
+    bool lockstepMode;
+    bool quit;
+    uint64_t frame;
+    uint64_t gameFirstFrame;    // Replies to earlier frames belong to an old game
+    uint32_t gameNumber;
+    uint32_t tick;
+    Point shownHead;            // Where the previous publish left things
+    Point shownTail;
+    Point shownFood;
+    Clock::time_point publishedAt;
+    long long replyCount;
+    long long missedCount;
+    double replyMicros;
+    #ifdef _WIN32
+    void* mapping;
+    #endif
+
+    void writeCell(const SnakeEngine& engine, Point p);
+    void beginWrite();
+    void endWrite(const SnakeEngine& engine);
+    bool takeReply(uint64_t minFrame, Direction& move);
+
+    BotLink(const BotLink&);
+    BotLink& operator=(const BotLink&);
+};
+
+#endif // SNAKE_BOT_H
@@ -0,0 +1,432 @@
+#include "snake_engine.h"
+
+#include <algorithm>
+
+bool isOpposite(Direction a, Direction b) {
+    return (a == UP && b == DOWN) || (a == DOWN && b == UP) ||
+           (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT);
+}
+
+Direction reverseOf(Direction d) {
+    switch (d) {
+        case UP:    return DOWN;
+        case DOWN:  return UP;
+        case LEFT:  return RIGHT;
+        case RIGHT: return LEFT;
+        case NONE:  break;
+    }
+    return NONE;
+}
+
+Point stepPoint(Point p, Direction d) {
+    switch (d) {
+        case UP:    p.y--; break;
+        case DOWN:  p.y++; break;
+        case LEFT:  p.x--; break;
+        case RIGHT: p.x++; break;
+        case NONE:  break;
+    }
+    return p;
+}
+
+const char* endReasonName(EndReason reason) {
+    switch (reason) {
+        case END_WALL:       return "wall";
+        case END_SELF:       return "self";
+        case END_BOARD_FULL: return "board-full";
+        case END_NONE:       break;
+    }
+    return "none";
+}
+
+SnakeEngine::SnakeEngine()
+    : foodPos{0, 0},
+      gameSeed(0),
+      currentDirection(NONE),
+      endReason(END_NONE),
+      currentScore(0),
+      currentSpeed(INITIAL_SPEED),
+      boardWidth(0),
+      boardHeight(0),
+      trackChanges(false),
+      changeOverflow(false),
+      changeLimit(0) {
+}
+
+void SnakeEngine::setChangeTracking(bool enabled) {
+    trackChanges = enabled;
+    clearChanges();
+}
+
+void SnakeEngine::clearChanges() {
+    changes.clear();
+    changeOverflow = false;
+}
+
+void SnakeEngine::setCell(const Point& p, CellKind kind) {
+    cellGrid.set(p.x, p.y, static_cast<unsigned char>(kind));
+    if (trackChanges && !changeOverflow) {
+        if (changes.size() >= changeLimit) {
+            changes.clear();
+            changeOverflow = true;
+        } else {
+            changes.push_back(cellIndex(p));
+        }
+    }
+}
+
+// Swap-remove a cell from the free list in O(1)
+void SnakeEngine::markOccupied(const Point& p) {
+    occupiedCount++;
+    if (large) return;
+    snakeBits.set(p.x, p.y);
+    int cell = cellIndex(p);
+    int slot = freeSlot[cell];
+    int last = freeCells.back();
+    freeCells[slot] = last;
+    freeSlot[last] = slot;
+    freeCells.pop_back();
+    freeSlot[cell] = -1;
+}
+
+void SnakeEngine::markFree(const Point& p, int slot) {
+    setCell(p, CELL_EMPTY);
+    occupiedCount--;
+    if (large) return;
+    snakeBits.clear(p.x, p.y);
+    int cell = cellIndex(p);
+    int end = static_cast<int>(freeCells.size());
+    if (slot >= 0 && slot < end) {
+        // Reverse markOccupied()'s swap: the cell that filled the slot goes back to the end
+        int moved = freeCells[slot];
+        freeSlot[moved] = end;
+        freeCells.push_back(moved);
+        freeCells[slot] = cell;
+        freeSlot[cell] = slot;
+        return;
+    }
+    freeSlot[cell] = end;
+    freeCells.push_back(cell);
+}
+
+void SnakeEngine::pushHead(const Point& p) {
+    if (!snake.empty()) {
+        setCell(snake.head(), CELL_BODY);
+    }
+    snake.pushHead(p);
+    markOccupied(p);
+    setCell(p, CELL_HEAD);
+}
+
+void SnakeEngine::popTail() {
+    markFree(snake.tail());
+    snake.popTail();
+}
+
+void SnakeEngine::spawnFood() {
+    if (freeCellCount() == 0) {
+        endReason = END_BOARD_FULL;
+        return;
+    }
+    if (large) {
+        if (!pickLargeBoardFood(foodPos)) {
+            endReason = END_BOARD_FULL;
+            return;
+        }
+    } else {
+        // Pick uniformly among free cells so food never lands on the snake
+        int cell = freeCells[rng.below(static_cast<uint32_t>(freeCells.size()))];
+        foodPos.x = cell % boardWidth;
+        foodPos.y = cell / boardWidth;
+    }
+    setCell(foodPos, CELL_FOOD);
+}
+
+// Large boards have no free list. Sample near the head so food stays within
+// reach, then anywhere, and only scan cells if the board is nearly full.
+bool SnakeEngine::pickLargeBoardFood(Point& out) {
+    const int ATTEMPTS = 32;
+    Point head = snake.head();
+    int x0 = std::max(head.x - FOOD_RANGE, 0);
+    int y0 = std::max(head.y - FOOD_RANGE, 0);
+    uint32_t spanX = static_cast<uint32_t>(std::min(head.x + FOOD_RANGE, boardWidth - 1) - x0 + 1);
+    uint32_t spanY = static_cast<uint32_t>(std::min(head.y + FOOD_RANGE, boardHeight - 1) - y0 + 1);
+    for (int i = 0; i < ATTEMPTS; ++i) {
+        Point p = {x0 + static_cast<int>(rng.below(spanX)), y0 + static_cast<int>(rng.below(spanY))};
+        if (cellAt(p) == CELL_EMPTY) {
+            out = p;
+            return true;
+        }
+    }
+    for (int i = 0; i < ATTEMPTS; ++i) {
+        Point p = {static_cast<int>(rng.below(static_cast<uint32_t>(boardWidth))),
+                   static_cast<int>(rng.below(static_cast<uint32_t>(boardHeight)))};
+        if (cellAt(p) == CELL_EMPTY) {
+            out = p;
+            return true;
+        }
+    }
+    int cellCount = boardWidth * boardHeight;
+    int start = static_cast<int>(rng.below(static_cast<uint32_t>(cellCount)));
+    for (int i = 0; i < cellCount; ++i) {
+        int cell = (start + i) % cellCount;
+        Point p = {cell % boardWidth, cell / boardWidth};
+        if (cellAt(p) == CELL_EMPTY) {
+            out = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Empty the board and mark every cell free
+void SnakeEngine::clearBoard(int width, int height) {
+    boardWidth = width;
+    boardHeight = height;
+
+    int cellCount = boardWidth * boardHeight;
+    snake.clear();
+    cellGrid.reset(boardWidth, boardHeight);
+    occupiedCount = 0;
+    large = cellCount > LARGE_BOARD_CELLS;
+    if (large) {
+        std::vector<int>().swap(freeCells);
+        std::vector<int>().swap(freeSlot);
+        snakeBits.reset(0, 0);
+    } else {
+        snakeBits.reset(boardWidth, boardHeight);
+        freeCells.resize(cellCount);
+        freeSlot.resize(cellCount);
+        for (int i = 0; i < cellCount; ++i) {
+            freeCells[i] = i;
+            freeSlot[i] = i;
+        }
+    }
+    changeLimit = static_cast<size_t>(std::min(cellCount, MAX_TRACKED_CHANGES));
+    clearChanges();
+}
+
+void SnakeEngine::reset(int width, int height, uint64_t seed) {
+    gameSeed = seed;
+    rng.reseed(seed);
+    width = std::min(std::max(width, 1), MAX_BOARD_CELLS);
+    height = std::min(std::max(height, 1), MAX_BOARD_CELLS / width);
+    clearBoard(width, height);
+
+    int centerX = boardWidth / 2;
+    int centerY = boardHeight / 2;
+
+    // Build from the tail forward so the head ends up at the front. Narrow
+    // boards get a shorter snake rather than overlapping segments.
+    if (centerX >= 2) {
+        pushHead({centerX - 2, centerY});
+    }
+    if (centerX >= 1) {
+        pushHead({centerX - 1, centerY});
+    }
+    pushHead({centerX, centerY});
+
+    currentDirection = NONE;
+    endReason = END_NONE;
+    currentScore = 0;
+    currentSpeed = INITIAL_SPEED;
+
+    spawnFood();
+}
+
+StepResult SnakeEngine::step(Direction requested, StepUndo* undo) {
+    if (isOver()) {
+        return STEP_IDLE;
+    }
+    if (undo) {
+        undo->oldTail = snake.tail();
+        undo->oldFood = foodPos;
+        undo->headSlot = -1;
+        undo->oldRngState = rng.state();
+        undo->oldDirection = currentDirection;
+        undo->oldSpeed = currentSpeed;
+        undo->moved = false;
+        undo->ate = false;
+    }
+
+    // Update direction (prevent 180-degree turns)
+    if (requested != NONE && !isOpposite(currentDirection, requested)) {
+        currentDirection = requested;
+    }
+
+    // Calculate new head position
+    if (currentDirection == NONE) {
+        return STEP_IDLE;
+    }
+    Point newHead = stepPoint(snake.head(), currentDirection);
+
+    // Check wall collision
+    if (newHead.x < 0 || newHead.x >= boardWidth ||
+        newHead.y < 0 || newHead.y >= boardHeight) {
+        endReason = END_WALL;
+        return STEP_GAME_OVER;
+    }
+
+    // Check self collision. The tail cell is vacated this tick unless
+    // food is eaten, so moving into it is legal.
+    bool eating = (newHead == foodPos);
+    if (cellAt(newHead) >= CELL_BODY && (eating || newHead != snake.tail())) {
+        endReason = END_SELF;
+        return STEP_GAME_OVER;
+    }
+
+    // Remove tail first if no food eaten, so a head entering the old
+    // tail cell leaves it marked occupied
+    if (!eating) {
+        popTail();
+    }
+
+    // Add new head
+    if (undo && !large) {
+        undo->headSlot = freeSlot[cellIndex(newHead)];
+    }
+    pushHead(newHead);
+    if (undo) {
+        undo->moved = true;
+        undo->ate = eating;
+    }
+
+    if (!eating) {
+        return STEP_MOVED;
+    }
+
+    currentScore++;
+    currentSpeed = std::max(50, INITIAL_SPEED - (currentScore * SPEED_INCREMENT));
+    spawnFood();
+    return isOver() ? STEP_GAME_OVER : STEP_ATE;
+}
+
+void SnakeEngine::undoStep(const StepUndo& undo) {
+    if (undo.moved) {
+        Point newHead = snake.head();
+        if (undo.ate) {
+            // Drop the food spawned by the meal; none if the board filled up
+            if (foodPos != newHead && cellAt(foodPos) == CELL_FOOD) {
+                setCell(foodPos, CELL_EMPTY);
+            }
+            currentScore--;
+        }
+        // Undo in reverse order so the free list returns to its exact order,
+        // which later food placement depends on
+        markFree(newHead, undo.headSlot);
+        snake.popHead();
+        if (!undo.ate) {
+            snake.pushTail(undo.oldTail);
+            markOccupied(undo.oldTail);
+            setCell(undo.oldTail, CELL_BODY);
+        }
+        setCell(snake.head(), CELL_HEAD);
+        foodPos = undo.oldFood;
+        if (undo.ate) {
+            setCell(foodPos, CELL_FOOD);
+        }
+    }
+    currentDirection = undo.oldDirection;
+    currentSpeed = undo.oldSpeed;
+    rng.setState(undo.oldRngState);
+    endReason = END_NONE;
+}
+
+void SnakeEngine::respawnFood() {
+    if (isOver()) return;
+    if (cellAt(foodPos) == CELL_FOOD) {
+        setCell(foodPos, CELL_EMPTY);
+    }
+    spawnFood();
+}
+
+void SnakeEngine::saveState(EngineState& out, bool freeOrder) const {
+    out.width = boardWidth;
+    out.height = boardHeight;
+    out.body = snake;
+    out.food = foodPos;
+    out.direction = currentDirection;
+    out.endReason = endReason;
+    out.score = currentScore;
+    out.speed = currentSpeed;
+    out.seed = gameSeed;
+    out.rngState = rng.state();
+    if (freeOrder) {
+        out.freeOrder = freeCells;
+    } else {
+        out.freeOrder.clear();
+    }
+}
+
+bool SnakeEngine::loadState(const EngineState& state) {
+    if (state.width < 1 || state.height < 1 || state.body.empty() ||
+        state.height > MAX_BOARD_CELLS / state.width) {
+        return false;
+    }
+
+    // Validate against sorted body cells before touching any member; this
+    // costs O(length log length) however large the board is
+    int cellCount = state.width * state.height;
+    std::vector<int> occupied;
+    occupied.reserve(state.body.size());
+    for (SnakeBody::Iterator it = state.body.begin(); it != state.body.end(); ++it) {
+        Point p = *it;
+        if (p.x < 0 || p.x >= state.width || p.y < 0 || p.y >= state.height) {
+            return false;
+        }
+        occupied.push_back(p.y * state.width + p.x);
+    }
+    std::sort(occupied.begin(), occupied.end());
+    if (std::adjacent_find(occupied.begin(), occupied.end()) != occupied.end()) {
+        return false;
+    }
+    bool boardFull = static_cast<int>(state.body.size()) == cellCount;
+    if (!boardFull) {
+        const Point& f = state.food;
+        if (f.x < 0 || f.x >= state.width || f.y < 0 || f.y >= state.height ||
+            std::binary_search(occupied.begin(), occupied.end(), f.y * state.width + f.x)) {
+            return false;
+        }
+    }
+    bool keepOrder = !state.freeOrder.empty() && cellCount <= LARGE_BOARD_CELLS;
+    if (keepOrder) {
+        if (state.freeOrder.size() != static_cast<size_t>(cellCount) - occupied.size()) {
+            return false;
+        }
+        std::vector<bool> listed(static_cast<size_t>(cellCount), false);
+        for (size_t i = 0; i < state.freeOrder.size(); ++i) {
+            int cell = state.freeOrder[i];
+            if (cell < 0 || cell >= cellCount || listed[static_cast<size_t>(cell)] ||
+                std::binary_search(occupied.begin(), occupied.end(), cell)) {
+                return false;
+            }
+            listed[static_cast<size_t>(cell)] = true;
+        }
+    }
+
+    clearBoard(state.width, state.height);
+    snake = state.body;
+    for (SnakeBody::Iterator it = snake.begin(); it != snake.end(); ++it) {
+        markOccupied(*it);
+        setCell(*it, CELL_BODY);
+    }
+    setCell(snake.head(), CELL_HEAD);
+    if (keepOrder) {
+        freeCells = state.freeOrder;
+        for (size_t i = 0; i < freeCells.size(); ++i) {
+            freeSlot[static_cast<size_t>(freeCells[i])] = static_cast<int>(i);
+        }
+    }
+
+    foodPos = state.food;
+    if (!boardFull) {
+        setCell(foodPos, CELL_FOOD);
+    }
+    currentDirection = state.direction;
+    endReason = state.endReason;
+    currentScore = state.score;
+    currentSpeed = state.speed;
+    gameSeed = state.seed;
+    rng.setState(state.rngState);
+    return true;
+}
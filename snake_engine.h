@@ -0,0 +1,320 @@
+// Headless snake simulation core.
+//
+// SnakeEngine holds the complete game state and advances it one tick per
+// step() call. It performs no terminal I/O and never sleeps, so frontends,
+// bots and tools can drive it as fast as they like.
+
+#ifndef SNAKE_ENGINE_H
+#define SNAKE_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snake_bitboard.h"
+#include "snake_grid.h"
+
+// Game Constants
+const int INITIAL_SPEED = 150; // milliseconds per frame
+const int SPEED_INCREMENT = 5; // speed increase per food eaten
+const int DEFAULT_WIDTH = 40;
+const int DEFAULT_HEIGHT = 20;
+
+// Bitboard specialised for the default board size
+typedef FixedBitboard<DEFAULT_WIDTH, DEFAULT_HEIGHT> DefaultBitboard;
+
+// Board size limits. Boards above LARGE_BOARD_CELLS keep no per-cell free
+// list or snake bitboard, so memory follows the visited area, and food
+// spawns near the head.
+const int LARGE_BOARD_CELLS = 1 << 18;
+const int MAX_BOARD_CELLS = 1 << 30;     // Cell indices must fit in an int
+const int FOOD_RANGE = 24;               // Large boards: max food distance from the head, per axis
+const int MAX_TRACKED_CHANGES = 1 << 16; // Change list cap before it overflows
+
+// Point structure for coordinates
+struct Point {
+    int x, y;
+
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y;
+    }
+
+    bool operator!=(const Point& other) const {
+        return !(*this == other);
+    }
+};
+
+// Direction enum
+enum Direction {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT,
+    NONE
+};
+
+// Board cell kinds. Anything at or above CELL_BODY is part of the snake.
+enum CellKind {
+    CELL_EMPTY,
+    CELL_FOOD,
+    CELL_BODY,
+    CELL_HEAD
+};
+
+// Outcome of a single step()
+enum StepResult {
+    STEP_IDLE,      // No direction chosen yet, or game already over
+    STEP_MOVED,
+    STEP_ATE,
+    STEP_GAME_OVER  // The game ended on this step
+};
+
+// Why the game ended
+enum EndReason {
+    END_NONE,
+    END_WALL,
+    END_SELF,
+    END_BOARD_FULL
+};
+
+bool isOpposite(Direction a, Direction b);
+// Opposite direction; NONE for NONE
+Direction reverseOf(Direction d);
+// Cell reached by moving one step from `p`; `p` itself for NONE
+Point stepPoint(Point p, Direction d);
+const char* endReasonName(EndReason reason);
+
+// Small, fast, seedable PRNG (xorshift64*). Each engine owns its own, so a
+// game is fully determined by its seed and inputs.
+class GameRng {
+public:
+    explicit GameRng(uint64_t seed = 0) { reseed(seed); }
+
+    // Scramble the seed with splitmix64 so any value, including 0, gives a
+    // well-mixed non-zero state
+    void reseed(uint64_t seed) {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        rngState = z ? z : 0x9E3779B97F4A7C15ULL;
+    }
+
+    uint64_t next() {
+        rngState ^= rngState >> 12;
+        rngState ^= rngState << 25;
+        rngState ^= rngState >> 27;
+        return rngState * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform value in [0, bound) without modulo bias (Lemire's method)
+    uint32_t below(uint32_t bound) {
+        uint64_t product = static_cast<uint64_t>(static_cast<uint32_t>(next() >> 32)) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(static_cast<uint32_t>(next() >> 32)) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    uint64_t state() const { return rngState; }
+    void setState(uint64_t state) { rngState = state ? state : 0x9E3779B97F4A7C15ULL; }
+
+private:
+    uint64_t rngState;
+};
+
+// Snake body packed as a tail anchor plus one 2-bit Direction per link
+// between neighbouring segments, in a ring of 64-bit words: about 32x
+// smaller than a deque of Points and read sequentially when iterated.
+// Pushing a head and popping the tail are O(1) (amortised when growing).
+class SnakeBody {
+public:
+    // Walks the body from head to tail
+    class Iterator {
+    public:
+        Point operator*() const { return pos; }
+        Iterator& operator++();
+        bool operator!=(const Iterator& other) const { return remaining != other.remaining; }
+        bool operator==(const Iterator& other) const { return remaining == other.remaining; }
+
+    private:
+        friend class SnakeBody;
+        const SnakeBody* body;
+        Point pos;
+        size_t remaining;  // Segments from here to the tail, inclusive
+    };
+
+    SnakeBody();
+
+    void clear();
+    // Add a segment in front of the head. Fails unless `p` is next to the
+    // current head (any point starts an empty body).
+    bool pushHead(const Point& p);
+    void popTail();
+    // Inverses of the two above, for undoing steps
+    void popHead();
+    bool pushTail(const Point& p);
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    Point head() const { return headPos; }
+    Point tail() const { return tailPos; }
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Flat snapshot: tail x/y, segment count, then the links packed 32 per
+    // word from the tail. load() rejects truncated or oversized input.
+    void save(std::vector<uint64_t>& out) const;
+    bool load(const uint64_t* data, size_t words);
+
+    size_t memoryBytes() const { return ring.capacity() * sizeof(uint64_t); }
+
+private:
+    static const int LINKS_PER_WORD = 32;
+
+    std::vector<uint64_t> ring;  // Capacity in links is a power of two
+    size_t first;                // Ring position of the link leaving the tail
+    size_t count;
+    Point headPos;
+    Point tailPos;
+
+    size_t mask() const { return ring.size() * LINKS_PER_WORD - 1; }
+    Direction link(size_t index) const;  // index 0 leaves the tail
+    void setLink(size_t index, Direction d);
+    void grow();
+};
+
+// What one step() changed, so undoStep() can reverse it exactly
+struct StepUndo {
+    Point oldTail;
+    Point oldFood;
+    int headSlot;  // Free-list position the new head was taken from
+    uint64_t oldRngState;
+    Direction oldDirection;
+    int oldSpeed;
+    bool moved;  // The head advanced (no collision, not idle)
+    bool ate;
+};
+
+// Complete engine state, for snapshots and synthetic setups
+struct EngineState {
+    int width;
+    int height;
+    SnakeBody body;
+    Point food;
+    Direction direction;
+    EndReason endReason;
+    int score;
+    int speed;
+    uint64_t seed;
+    uint64_t rngState;
+    // Order of the free-cell list, which food placement indexes into. Only
+    // kept when asked for, and always empty on large boards; without it,
+    // loadState() rebuilds the list and later food can land elsewhere.
+    std::vector<int> freeOrder;
+};
+
+class SnakeEngine {
+public:
+    SnakeEngine();
+
+    // Start a new game on a width x height board (clamped to
+    // MAX_BOARD_CELLS). The seed fully determines food placement, so equal
+    // seeds and inputs replay identically.
+    void reset(int width, int height, uint64_t seed);
+
+    // Advance one tick. `requested` replaces the current direction unless it
+    // is NONE or a 180-degree turn. If `undo` is set, it receives what
+    // undoStep() needs to take the tick back.
+    StepResult step(Direction requested, StepUndo* undo = nullptr);
+
+    // Reverse the most recent step() that has not been undone yet
+    void undoStep(const StepUndo& undo);
+
+    // Move the food to a new free cell: uniformly chosen on normal boards,
+    // within FOOD_RANGE of the head on large ones
+    void respawnFood();
+
+    // With `freeOrder`, also copy the free-cell list so that loading the
+    // state places food exactly as this game will (O(free cells) more)
+    void saveState(EngineState& out, bool freeOrder = false) const;
+    // Replace the whole game state. Returns false, leaving the engine
+    // untouched, if the body leaves the board or overlaps itself or the food,
+    // or a non-empty freeOrder does not list exactly the free cells.
+    bool loadState(const EngineState& state);
+
+    int width() const { return boardWidth; }
+    int height() const { return boardHeight; }
+    const SnakeBody& body() const { return snake; }
+    Point head() const { return snake.head(); }
+    Point food() const { return foodPos; }
+    Direction direction() const { return currentDirection; }
+    int score() const { return currentScore; }
+    int speed() const { return currentSpeed; }
+    bool isOver() const { return endReason != END_NONE; }
+    EndReason reason() const { return endReason; }
+    uint64_t seed() const { return gameSeed; }
+    uint64_t rngState() const { return rng.state(); }
+
+    int cellIndex(const Point& p) const { return p.y * boardWidth + p.x; }
+    CellKind cellAt(const Point& p) const { return static_cast<CellKind>(cellGrid.get(p.x, p.y)); }
+    CellKind cellAt(int x, int y) const { return static_cast<CellKind>(cellGrid.get(x, y)); }
+    // Chunked CellKind storage, e.g. for memory figures
+    const CellGrid& grid() const { return cellGrid; }
+    bool largeBoard() const { return large; }
+    // Snake cells as a bitboard, for flood fills (see snake_bitboard.h).
+    // Sized 0x0 on large boards.
+    const Bitboard& bodyBits() const { return snakeBits; }
+    int freeCellCount() const { return boardWidth * boardHeight - occupiedCount; }
+
+    // Change tracking for incremental renderers. When enabled, every cell
+    // write is recorded until clearChanges(). If more writes pile up than
+    // the board has cells (or MAX_TRACKED_CHANGES), the list is dropped and
+    // changesOverflowed() is set so the consumer falls back to a full
+    // compare.
+    void setChangeTracking(bool enabled);
+    bool changeTracking() const { return trackChanges; }
+    const std::vector<int>& changedCells() const { return changes; }
+    bool changesOverflowed() const { return changeOverflow; }
+    void clearChanges();
+
+private:
+    SnakeBody snake;
+    CellGrid cellGrid;
+    bool large;                  // No free list; see LARGE_BOARD_CELLS
+    int occupiedCount;
+    std::vector<int> freeCells;  // Dense list of unoccupied cell indices (normal boards)
+    std::vector<int> freeSlot;   // Cell index -> position in freeCells, -1 if occupied
+    Bitboard snakeBits;          // Occupied cells (normal boards)
+    Point foodPos;
+    GameRng rng;
+    uint64_t gameSeed;
+    Direction currentDirection;
+    EndReason endReason;
+    int currentScore;
+    int currentSpeed;
+    int boardWidth;
+    int boardHeight;
+    bool trackChanges;
+    bool changeOverflow;
+    size_t changeLimit;
+    std::vector<int> changes;
+
+    void clearBoard(int width, int height);
+    void setCell(const Point& p, CellKind kind);
+    void markOccupied(const Point& p);
+    // With `slot`, puts the cell back where markOccupied() took it from
+    void markFree(const Point& p, int slot = -1);
+    void pushHead(const Point& p);
+    void popTail();
+    void spawnFood();
+    bool pickLargeBoardFood(Point& out);
+};
+
+#endif // SNAKE_ENGINE_H
@@ -0,0 +1,127 @@
+#include "snake_feed.h"
+
+#include "snake_terminal.h"
+
+FrameFeed::FrameFeed()
+    : chainBytes(0),
+      poolCursor(0) {
+}
+
+std::shared_ptr<std::string> FrameFeed::takeBuffer() {
+    // A pooled buffer only the pool still refers to is free; clear() keeps
+    // its capacity, so steady play allocates nothing
+    for (size_t i = 0; i < pool.size(); ++i) {
+        size_t index = (poolCursor + i) % pool.size();
+        if (pool[index].use_count() == 1) {
+            poolCursor = index + 1;
+            pool[index]->clear();
+            return pool[index];
+        }
+    }
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>();
+    if (pool.size() < static_cast<size_t>(POOL_BUFFERS)) {
+        pool.push_back(buffer);
+    }
+    return buffer;
+}
+
+SharedFrame FrameFeed::publish(const std::string& frame, bool keyframe, bool clear) {
+    std::shared_ptr<std::string> buffer = takeBuffer();
+    if (keyframe && clear) {
+        *buffer += "\033[2J";
+    }
+    appendCrlf(*buffer, frame.data(), frame.size());
+
+    if (keyframe) {
+        frames.clear();
+        chainBytes = 0;
+    }
+    if (!frames.empty() || keyframe) {
+        frames.push_back(buffer);
+        chainBytes += buffer->size();
+    }
+    return buffer;
+}
+
+bool FrameFeed::wantsKeyframe() const {
+    return frames.empty() ||
+           frames.size() >= static_cast<size_t>(KEYFRAME_INTERVAL) ||
+           chainBytes >= static_cast<size_t>(MAX_CHAIN_BYTES);
+}
+
+void FrameFeed::reset() {
+    frames.clear();
+    chainBytes = 0;
+}
+
+FrameQueue::FrameQueue()
+    : offset(0),
+      total(0) {
+}
+
+void FrameQueue::push(const SharedFrame& frame) {
+    if (frame->empty()) return;
+    Entry entry = { frame, nullptr };
+    entries.push_back(entry);
+    total += frame->size();
+}
+
+void FrameQueue::write(const char* data, size_t size) {
+    if (size == 0) return;
+    if (entries.empty() || !entries.back().owned) {
+        std::shared_ptr<std::string> buffer;
+        buffer.swap(spare);
+        if (!buffer) buffer = std::make_shared<std::string>();
+        Entry entry = { buffer, buffer.get() };
+        entries.push_back(entry);
+    }
+    entries.back().owned->append(data, size);
+    total += size;
+}
+
+void FrameQueue::discardUnsent() {
+    if (offset > 0) {
+        // Keep the partly sent front entry
+        entries.resize(1);
+        total = entries.front().frame->size() - offset;
+    } else {
+        while (!entries.empty()) {
+            consume(entries.front().frame->size());
+        }
+    }
+}
+
+#ifndef _WIN32
+int FrameQueue::gather(struct iovec* slices, int max) const {
+    int count = 0;
+    size_t skip = offset;
+    for (std::deque<Entry>::const_iterator it = entries.begin();
+         it != entries.end() && count < max; ++it) {
+        slices[count].iov_base = const_cast<char*>(it->frame->data() + skip);
+        slices[count].iov_len = it->frame->size() - skip;
+        skip = 0;
+        count++;
+    }
+    return count;
+}
+#endif
+
+void FrameQueue::consume(size_t sent) {
+    total -= sent;
+    while (sent > 0) {
+        Entry& front = entries.front();
+        size_t remaining = front.frame->size() - offset;
+        if (sent < remaining) {
+            offset += sent;
+            return;
+        }
+        sent -= remaining;
+        offset = 0;
+        if (front.owned && front.frame.use_count() == 1) {
+            // Nothing else can refer to a private buffer; keep it for reuse
+            spare = std::const_pointer_cast<std::string>(front.frame);
+            spare->clear();
+        }
+        entries.pop_front();
+    }
+}
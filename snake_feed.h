@@ -0,0 +1,102 @@
+// Encode-once frame fan-out for spectators.
+//
+// A FrameFeed holds one game's frames, each composed once and kept as an
+// immutable, reference-counted buffer (SharedFrame). Every viewer's
+// FrameQueue refers to the same buffers, so another viewer costs a pointer
+// per frame rather than a render or a copy. Buffers go back to the feed's
+// pool once no queue refers to them.
+//
+// The feed keeps the latest keyframe (a full repaint) and every delta after
+// it. A viewer that joins, or falls so far behind that its queue passes a
+// limit, drops whatever it has not started sending and takes that chain
+// instead, which brings its screen up to the live frame without unbounded
+// buffering. The feed asks for a keyframe every KEYFRAME_INTERVAL frames, or
+// sooner if the chain grows large, to keep catching up cheap.
+
+#ifndef SNAKE_FEED_H
+#define SNAKE_FEED_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+typedef std::shared_ptr<const std::string> SharedFrame;
+
+class FrameFeed {
+public:
+    static const int KEYFRAME_INTERVAL = 64;      // Frames between requested keyframes
+    static const int MAX_CHAIN_BYTES = 32 * 1024; // Chain size that brings a keyframe forward
+    static const int POOL_BUFFERS = 256;          // Recycled frame buffers kept
+
+    FrameFeed();
+
+    // Encode a composed frame once, turning "\n" into "\r\n" for clients
+    // with no tty. A keyframe starts a new chain; `clear` makes it clear the
+    // screen first, for when the layout may have changed.
+    SharedFrame publish(const std::string& frame, bool keyframe, bool clear);
+
+    // The next frame should be a keyframe
+    bool wantsKeyframe() const;
+
+    // Latest keyframe and every frame since, oldest first; empty until the
+    // first keyframe
+    const std::vector<SharedFrame>& chain() const { return frames; }
+
+    // Forget the chain, e.g. after nobody has been watching
+    void reset();
+
+private:
+    std::vector<SharedFrame> frames;
+    size_t chainBytes;
+    std::vector<std::shared_ptr<std::string> > pool;
+    size_t poolCursor;
+
+    std::shared_ptr<std::string> takeBuffer();
+};
+
+// Bytes waiting to go to one client, oldest first: frames shared with other
+// clients, and bytes written for this client alone
+class FrameQueue {
+public:
+    FrameQueue();
+
+    void push(const SharedFrame& frame);
+
+    // Copy bytes for this client alone to the end of the queue
+    void write(const char* data, size_t size);
+
+    size_t bytes() const { return total; }
+    bool empty() const { return total == 0; }
+
+    // Drop everything not yet started. A frame that is partly sent stays,
+    // so the terminal never sees half an escape sequence.
+    void discardUnsent();
+
+#ifndef _WIN32
+    // Point up to `max` slices at the unsent bytes, oldest first; returns
+    // how many were filled, for writev() or sendmsg()
+    int gather(struct iovec* slices, int max) const;
+#endif
+
+    // `sent` bytes from the front have gone out
+    void consume(size_t sent);
+
+private:
+    struct Entry {
+        SharedFrame frame;
+        std::string* owned;  // Set if the bytes are this queue's alone
+    };
+
+    std::deque<Entry> entries;
+    size_t offset;  // Bytes of the front entry already sent
+    size_t total;
+    std::shared_ptr<std::string> spare;  // Emptied private buffer, for reuse
+};
+
+#endif // SNAKE_FEED_H
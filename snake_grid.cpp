@@ -0,0 +1,32 @@
+#include "snake_grid.h"
+
+#include <cstring>
+
+CellGrid::CellGrid()
+    : chunksPerRow(0),
+      chunkCount(0) {
+}
+
+void CellGrid::reset(int width, int height) {
+    chunksPerRow = (width + CHUNK_SIZE - 1) >> CHUNK_BITS;
+    int rows = (height + CHUNK_SIZE - 1) >> CHUNK_BITS;
+    size_t count = static_cast<size_t>(chunksPerRow) * rows;
+
+    // A single-chunk board keeps its chunk so resets do not reallocate
+    if (count == 1 && chunks.size() == 1 && chunks[0]) {
+        memset(chunks[0]->cells, 0, sizeof(chunks[0]->cells));
+        return;
+    }
+    chunks.clear();
+    chunks.resize(count);
+    chunkCount = 0;
+}
+
+void CellGrid::allocate(std::unique_ptr<Chunk>& slot) {
+    slot.reset(new Chunk());  // Value-initialised: every cell 0
+    chunkCount++;
+}
+
+size_t CellGrid::memoryBytes() const {
+    return chunks.capacity() * sizeof(chunks[0]) + static_cast<size_t>(chunkCount) * sizeof(Chunk);
+}
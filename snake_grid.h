@@ -0,0 +1,60 @@
+// Sparse cell storage for SnakeEngine boards.
+//
+// CellGrid splits the board into fixed 64x64 chunks that are allocated the
+// first time a non-empty cell is written to them. Untouched chunks cost one
+// null pointer, so memory follows the area the snake has visited rather
+// than the size of the board, and a small board is a single chunk.
+
+#ifndef SNAKE_GRID_H
+#define SNAKE_GRID_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class CellGrid {
+public:
+    static const int CHUNK_BITS = 6;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;  // Cells per chunk side
+
+    CellGrid();
+
+    // Drop every chunk and size the grid; all cells read as 0 afterwards
+    void reset(int width, int height);
+
+    unsigned char get(int x, int y) const {
+        const Chunk* chunk = chunks[chunkIndex(x, y)].get();
+        return chunk ? chunk->cells[offset(x, y)] : 0;
+    }
+
+    void set(int x, int y, unsigned char value) {
+        std::unique_ptr<Chunk>& chunk = chunks[chunkIndex(x, y)];
+        if (!chunk) {
+            if (value == 0) return;  // Already reads as 0; stay unallocated
+            allocate(chunk);
+        }
+        chunk->cells[offset(x, y)] = value;
+    }
+
+    int allocatedChunks() const { return chunkCount; }
+    size_t memoryBytes() const;
+
+private:
+    struct Chunk {
+        unsigned char cells[CHUNK_SIZE * CHUNK_SIZE];
+    };
+
+    std::vector<std::unique_ptr<Chunk>> chunks;  // Row-major chunk directory
+    int chunksPerRow;
+    int chunkCount;
+
+    int chunkIndex(int x, int y) const {
+        return (y >> CHUNK_BITS) * chunksPerRow + (x >> CHUNK_BITS);
+    }
+    static int offset(int x, int y) {
+        return ((y & (CHUNK_SIZE - 1)) << CHUNK_BITS) | (x & (CHUNK_SIZE - 1));
+    }
+    void allocate(std::unique_ptr<Chunk>& slot);
+};
+
+#endif // SNAKE_GRID_H
@@ -0,0 +1,552 @@
+#include "snake_policy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const Direction ALL_DIRECTIONS[] = {UP, DOWN, LEFT, RIGHT};
+
+// Heads for the food by the shortest safe step, but avoids stepping into a
+// pocket with fewer free cells than the snake is long when another move
+// has more room. Room is counted with a bitboard flood fill.
+class GreedyPolicy : public SnakePolicy {
+public:
+    explicit GreedyPolicy(uint64_t seed) : rng(seed) {}
+
+    void newGame(const SnakeEngine&) {}
+
+    Direction choose(const SnakeEngine& engine) {
+        Point food = engine.food();
+        Direction best = engine.direction();
+        int bestRoom = -1;
+        int bestDistance = -1;
+        uint32_t ties = 0;
+        int length = static_cast<int>(engine.body().size());
+        bool fixed = fixedBlocked.load(engine.bodyBits());
+        bool flood = fixed || engine.bodyBits().width() > 0;  // Large boards have no bitboard
+        int lastRoom = -1;
+
+        for (int i = 0; i < 4; ++i) {
+            Direction d = ALL_DIRECTIONS[i];
+            if (!isSafeMove(engine, d)) continue;
+            Point next = stepPoint(engine.head(), d);
+            int room = length;
+            if (flood) {
+                // Moves into the same free area share one flood fill. A
+                // fill started on the tail cell spans every area around it,
+                // so it is not reused.
+                int area = lastRoom >= 0 && inRegion(next, fixed) ? lastRoom : roomAt(engine, next, fixed);
+                lastRoom = engine.cellAt(next) < CELL_BODY ? area : -1;
+                room = std::min(area, length);
+            }
+            int distance = std::abs(next.x - food.x) + std::abs(next.y - food.y);
+            if (room > bestRoom || (room == bestRoom && distance < bestDistance)) {
+                best = d;
+                bestRoom = room;
+                bestDistance = distance;
+                ties = 1;
+            } else if (room == bestRoom && distance == bestDistance && rng.below(++ties) == 0) {
+                best = d;  // Reservoir-pick uniformly among equally good moves
+            }
+        }
+        return best;
+    }
+
+private:
+    GameRng rng;
+    DefaultBitboard fixedBlocked;  // Copy of the body on default-size boards
+    DefaultBitboard fixedRegion;
+    Bitboard region;
+
+    // Is `p` in the area filled by the last roomAt()?
+    bool inRegion(Point p, bool fixed) const {
+        return fixed ? fixedRegion.test(p.x, p.y) : region.test(p.x, p.y);
+    }
+
+    // Free cells the head could still reach after moving to `next`
+    int roomAt(const SnakeEngine& engine, Point next, bool fixed) {
+        if (fixed) {
+            return bitboard::reachableFrom(fixedBlocked, next.x, next.y, fixedRegion);
+        }
+        const Bitboard& blocked = engine.bodyBits();
+        if (region.width() != blocked.width() || region.height() != blocked.height()) {
+            region.reset(blocked.width(), blocked.height());
+        }
+        return bitboard::reachableFrom(blocked, next.x, next.y, region);
+    }
+};
+
+// Autopilot tuning
+const int PACKING_FILL_PERCENT = 50;  // Follow the Hamiltonian cycle once the snake fills this much
+const int BUDGET_CHECK_INTERVAL = 64; // Search expansions between clock reads
+
+Direction directionTo(Point from, Point to) {
+    if (to.x < from.x) return LEFT;
+    if (to.x > from.x) return RIGHT;
+    if (to.y < from.y) return UP;
+    if (to.y > from.y) return DOWN;
+    return NONE;
+}
+
+// Plans a shortest path to the food with BFS and only takes it if the
+// snake could still reach its tail after eating. Otherwise it stalls by
+// chasing its tail, and once the board is half full it follows a
+// Hamiltonian cycle so the body packs without trapping itself.
+//
+// Searches are time-aware: a body cell counts as free once the head could
+// not reach it before the tail has moved off it. That needs each segment's
+// age, which is kept per cell as the tick the head entered it, so a tick
+// costs O(1) bookkeeping instead of a walk over the body. A planned path
+// stays valid while the food is unchanged (cells on it only ever free up),
+// so it is reused tick after tick and only replanned after eating.
+class AutopilotPolicy : public SnakePolicy {
+public:
+    AutopilotPolicy(uint64_t seed, int budgetMicros)
+        : rng(seed),
+          budget(budgetMicros),
+          engine(nullptr),
+          width(0),
+          height(0),
+          tick(0),
+          lastMeal(0),
+          lastLength(0),
+          lastHead(),
+          pathPos(0),
+          pathFood(),
+          generation(0),
+          pathBase(0),
+          pathEnd(0),
+          virtualGeneration(0),
+          virtualLength(0),
+          expansions(0),
+          outOfTime(false) {
+    }
+
+    void newGame(const SnakeEngine& game) {
+        if (game.width() != width || game.height() != height) {
+            width = game.width();
+            height = game.height();
+            int cellCount = width * height;
+            entered.assign(cellCount, 0);
+            seen.assign(cellCount, 0);
+            parent.assign(cellCount, -1);
+            depth.assign(cellCount, 0);
+            grown.assign(cellCount, 0);
+            open.reserve(cellCount);
+            deferred.reserve(cellCount);
+            pathMark.assign(cellCount, 0);
+            virtualMark.assign(cellCount, 0);
+            virtualPos.assign(cellCount, 0);
+            buildCycle();
+        }
+        resync(game);
+    }
+
+    Direction choose(const SnakeEngine& game) {
+        engine = &game;
+        sync();
+        expansions = 0;
+        outOfTime = false;
+        if (budget > 0) {
+            deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget);
+        }
+
+        Point head = game.head();
+        if (pathPos < path.size() && blockedFor(cellOf(path[pathPos]), false) <= 1) {
+            return directionTo(head, path[pathPos]);
+        }
+        path.clear();
+
+        int cellCount = width * height;
+        bool packing = !cycleNext.empty() &&
+            static_cast<int>(game.body().size()) * 100 >= cellCount * PACKING_FILL_PERCENT;
+        if (packing && !starving()) {
+            Direction d = followCycle();
+            if (d != NONE) return d;
+        }
+        if (planToFood()) {
+            return directionTo(head, path[0]);
+        }
+        return stall();
+    }
+
+private:
+    GameRng rng;
+    int budget;
+    const SnakeEngine* engine;   // Game being played during choose()
+    int width;
+    int height;
+    long long tick;              // Head moves seen this game
+    std::vector<long long> entered; // Tick the head entered each body cell
+    long long lastMeal;          // Tick the snake last grew
+    size_t lastLength;
+    Point lastHead;
+    std::vector<int> cycleNext;  // Successor of each cell on the cycle; empty if none exists
+
+    // Cached path to `pathFood`; path[pathPos] is the next cell to enter
+    std::vector<Point> path;
+    size_t pathPos;
+    Point pathFood;
+
+    // Search scratch, reset in O(1) by bumping a generation counter
+    std::vector<uint32_t> seen;
+    uint32_t generation;
+    std::vector<int> parent;
+    std::vector<int> depth;
+    std::vector<unsigned char> grown;  // Route to the cell passes the food
+    std::vector<int> open;      // Nodes at the current estimated path length
+    std::vector<int> deferred;  // Nodes whose estimate is 2 higher
+    std::vector<uint32_t> pathMark;    // pathBase + path index + 1 for cells on `path`
+    uint32_t pathBase;                 // Marks at or below this are from older paths
+    uint32_t pathEnd;                  // Highest mark written so far
+    std::vector<uint32_t> virtualMark; // Snake body as it will be after the planned path
+    std::vector<int> virtualPos;
+    uint32_t virtualGeneration;
+    int virtualLength;
+
+    std::chrono::steady_clock::time_point deadline;
+    int expansions;
+    bool outOfTime;
+
+    int cellOf(Point p) const { return p.y * width + p.x; }
+    Point pointOf(int cell) const { return {cell % width, cell / width}; }
+
+    // Restamp every segment, e.g. after a new game or an unexpected jump
+    void resync(const SnakeEngine& game) {
+        const SnakeBody& body = game.body();
+        tick = 0;
+        lastMeal = 0;
+        lastLength = body.size();
+        long long age = 0;
+        for (SnakeBody::Iterator it = body.begin(); it != body.end(); ++it) {
+            entered[cellOf(*it)] = age--;
+        }
+        lastHead = game.head();
+        path.clear();
+        pathPos = 0;
+    }
+
+    // Catch up with the one step taken since the last choose()
+    void sync() {
+        Point head = engine->head();
+        if (head != lastHead) {
+            if (stepPoint(lastHead, engine->direction()) != head) {
+                resync(*engine);
+                return;
+            }
+            entered[cellOf(head)] = ++tick;
+            lastHead = head;
+            if (engine->body().size() != lastLength) {
+                lastLength = engine->body().size();
+                lastMeal = tick;
+            }
+
+            if (pathPos < path.size()) {
+                if (path[pathPos] == head) {
+                    pathPos++;
+                } else if (pathMark[cellOf(head)] > pathBase + pathPos) {
+                    // Cut across to a later point on the same path
+                    pathPos = pathMark[cellOf(head)] - pathBase;
+                } else {
+                    path.clear();
+                }
+            }
+        }
+        if (engine->food() != pathFood) {
+            path.clear();
+        }
+    }
+
+    // A long spell without food means the snake is circling; see stall()
+    bool starving() const {
+        return tick - lastMeal > static_cast<long long>(width) * height;
+    }
+
+    bool timeUp() {
+        if (budget > 0 && !outOfTime && ++expansions % BUDGET_CHECK_INTERVAL == 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            outOfTime = true;
+        }
+        return outOfTime;
+    }
+
+    // Ticks until `cell` is free: 0 if free now, 1 for the current tail
+    int blockedFor(int cell, bool virtualBody) const {
+        if (virtualBody) {
+            return virtualMark[cell] == virtualGeneration ? virtualLength - virtualPos[cell] : 0;
+        }
+        if (engine->cellAt(cell % width, cell / width) < CELL_BODY) {
+            return 0;
+        }
+        long long age = tick - entered[cell];
+        return static_cast<int>(static_cast<long long>(engine->body().size()) - age);
+    }
+
+    // Cell a first move must not enter because the engine would ignore the reversal
+    int reverseCell() const {
+        Direction back = reverseOf(engine->direction());
+        if (back == NONE) return -1;
+        Point p = stepPoint(engine->head(), back);
+        if (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height) return -1;
+        return cellOf(p);
+    }
+
+    // A* search from `start`, entered at time `startTime`, to `goal` through
+    // cells that are free when the head would reach them. The first step may
+    // not enter `banned`. A route that passes the food grows the snake, so
+    // body cells beyond it free up one tick later. Returns the time the goal
+    // is reached, or -1 if unreachable or out of time.
+    //
+    // With unit steps and a Manhattan estimate, a step either keeps a node's
+    // estimated total or adds 2, so two stacks serve as the priority queue.
+    // Obstacles only ever clear with time, so reaching a cell earlier never
+    // rules out a route that reaching it later would allow.
+    int search(int start, int startTime, int banned, int goal, bool virtualBody) {
+        if (start == goal) return startTime;
+        if (++generation == 0) {
+            std::fill(seen.begin(), seen.end(), 0u);
+            generation = 1;
+        }
+        int foodCell = virtualBody ? -1 : cellOf(engine->food());
+        int goalX = goal % width;
+        int goalY = goal / width;
+        seen[start] = generation;
+        depth[start] = startTime;
+        grown[start] = start == foodCell;
+        open.clear();
+        deferred.clear();
+        open.push_back(start);
+
+        while (!open.empty() || !deferred.empty()) {
+            if (open.empty()) {
+                open.swap(deferred);  // Every node at the current estimate is done
+            }
+            if (timeUp()) return -1;
+            int cell = open.back();
+            open.pop_back();
+            int t = depth[cell] + 1;
+            int x = cell % width;
+            int y = cell / width;
+            int neighbours[4];
+            bool closer[4];
+            int count = 0;
+            if (y > 0) { closer[count] = goalY < y; neighbours[count++] = cell - width; }
+            if (y < height - 1) { closer[count] = goalY > y; neighbours[count++] = cell + width; }
+            if (x > 0) { closer[count] = goalX < x; neighbours[count++] = cell - 1; }
+            if (x < width - 1) { closer[count] = goalX > x; neighbours[count++] = cell + 1; }
+
+            for (int i = 0; i < count; ++i) {
+                int next = neighbours[i];
+                if (seen[next] == generation && depth[next] <= t) continue;
+                if (cell == start && next == banned) continue;
+                if (blockedFor(next, virtualBody) + grown[cell] > t) continue;
+                seen[next] = generation;
+                parent[next] = cell;
+                depth[next] = t;
+                grown[next] = grown[cell] || next == foodCell;
+                if (next == goal) return t;
+                if (closer[i]) {
+                    open.push_back(next);
+                } else {
+                    deferred.push_back(next);
+                }
+            }
+        }
+        return -1;
+    }
+
+    // Could the snake still reach its tail after following `path` and eating?
+    bool tailReachableAfterPath() {
+        const SnakeBody& body = engine->body();
+        int steps = static_cast<int>(path.size());
+        virtualLength = static_cast<int>(body.size()) + 1;
+
+        if (++virtualGeneration == 0) {
+            std::fill(virtualMark.begin(), virtualMark.end(), 0u);
+            virtualGeneration = 1;
+        }
+        // Segments that are still on the board, then the path (head first)
+        int tailPos = virtualLength - 1;
+        int vtail = -1;
+        SnakeBody::Iterator segment = body.begin();
+        for (int pos = steps; pos < virtualLength; ++pos, ++segment) {
+            int cell = cellOf(*segment);
+            virtualMark[cell] = virtualGeneration;
+            virtualPos[cell] = pos;
+            vtail = cell;
+        }
+        for (int pos = 0; pos < steps && pos < virtualLength; ++pos) {
+            int cell = cellOf(path[steps - 1 - pos]);
+            virtualMark[cell] = virtualGeneration;
+            virtualPos[cell] = pos;
+        }
+        if (tailPos < steps) {
+            vtail = cellOf(path[steps - 1 - tailPos]);
+        }
+        int vneck = steps >= 2 ? cellOf(path[steps - 2]) : cellOf(body.head());
+
+        return search(cellOf(path[steps - 1]), 0, vneck, vtail, true) >= 0;
+    }
+
+    bool planToFood() {
+        Point food = engine->food();
+        int foodCell = cellOf(food);
+        int steps = search(cellOf(engine->head()), 0, reverseCell(), foodCell, false);
+        if (steps <= 0) return false;
+
+        path.resize(steps);
+        for (int i = steps - 1, cell = foodCell; i >= 0; --i, cell = parent[cell]) {
+            path[i] = pointOf(cell);
+        }
+        if (!tailReachableAfterPath()) {
+            path.clear();
+            return false;
+        }
+
+        // Raise the base past the old marks instead of clearing them, so a
+        // replan costs O(path) rather than O(board)
+        pathBase = pathEnd;
+        if (pathBase > UINT32_MAX - static_cast<uint32_t>(steps)) {
+            std::fill(pathMark.begin(), pathMark.end(), 0u);
+            pathBase = 0;
+        }
+        pathEnd = pathBase + static_cast<uint32_t>(steps);
+        for (int i = 0; i < steps; ++i) {
+            pathMark[cellOf(path[i])] = pathBase + static_cast<uint32_t>(i + 1);
+        }
+        pathPos = 0;
+        pathFood = food;
+        return true;
+    }
+
+    // Can the head move into `next` now and still get back to its tail?
+    bool survivable(Point next) {
+        int tail = cellOf(engine->body().tail());
+        return search(cellOf(next), 1, cellOf(engine->head()), tail, false) >= 0;
+    }
+
+    Direction followCycle() {
+        Point head = engine->head();
+        Point next = pointOf(cycleNext[cellOf(head)]);
+        Direction d = directionTo(head, next);
+        if (!isSafeMove(*engine, d)) return NONE;
+        if (next == engine->food()) {
+            path.assign(1, next);
+            bool safe = tailReachableAfterPath();
+            path.clear();
+            return safe ? d : NONE;
+        }
+        return survivable(next) ? d : NONE;
+    }
+
+    // No safe way to the food: pick the move that keeps the tail reachable
+    // by the longest route, preferring the cycle. Chasing the tail can lock
+    // the body into a loop that never changes shape, so after a long spell
+    // without food the pick among safe moves becomes random. Falls back to
+    // any move that survives this tick.
+    Direction stall() {
+        Point head = engine->head();
+        Direction preferred = cycleNext.empty() ? NONE
+            : directionTo(head, pointOf(cycleNext[cellOf(head)]));
+        int tail = cellOf(engine->body().tail());
+        Direction best = NONE;
+        int bestScore = -1;
+        Direction fallback = NONE;
+
+        for (int i = 0; i < 4; ++i) {
+            Direction d = ALL_DIRECTIONS[i];
+            if (!isSafeMove(*engine, d)) continue;
+            Point next = stepPoint(head, d);
+            if (fallback == NONE || stepPoint(head, fallback) == engine->food()) {
+                fallback = d;
+            }
+            if (next == engine->food() || outOfTime) continue;
+
+            int reach = search(cellOf(next), 1, cellOf(head), tail, false);
+            if (reach < 0) continue;
+            int score = starving() ? static_cast<int>(rng.below(1024))
+                : d == preferred ? width * height + 1 : reach;
+            if (score > bestScore) {
+                best = d;
+                bestScore = score;
+            }
+        }
+        if (best != NONE) return best;
+        return fallback != NONE ? fallback : engine->direction();
+    }
+
+    // Boustrophedon cycle through every cell with one edge column kept as
+    // the way back. Exists when a side is even and both are at least 2.
+    void buildCycle() {
+        cycleNext.clear();
+        bool transpose = height % 2 != 0;
+        int rows = transpose ? width : height;
+        int cols = transpose ? height : width;
+        if (rows % 2 != 0 || rows < 2 || cols < 2) return;
+
+        std::vector<int> order;
+        order.reserve(rows * cols);
+        for (int c = 0; c < cols; ++c) order.push_back(c);  // Row 0, every column
+        for (int r = 1; r < rows; ++r) {
+            for (int i = 1; i < cols; ++i) {
+                order.push_back(r * cols + (r % 2 != 0 ? cols - i : i));
+            }
+        }
+        for (int r = rows - 1; r >= 1; --r) order.push_back(r * cols);  // Back up column 0
+
+        cycleNext.resize(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            int from = order[i];
+            int to = order[(i + 1) % order.size()];
+            if (transpose) {
+                from = (from % cols) * width + from / cols;
+                to = (to % cols) * width + to / cols;
+            }
+            cycleNext[from] = to;
+        }
+    }
+};
+
+} // namespace
+
+bool isSafeMove(const SnakeEngine& engine, Direction d) {
+    if (d == NONE || isOpposite(engine.direction(), d)) {
+        return false;
+    }
+    Point next = stepPoint(engine.head(), d);
+    if (next.x < 0 || next.x >= engine.width() || next.y < 0 || next.y >= engine.height()) {
+        return false;
+    }
+    CellKind kind = engine.cellAt(next);
+    if (kind < CELL_BODY) {
+        return true;
+    }
+    // The tail moves out of the way this tick (food never sits on it)
+    return next == engine.body().tail();
+}
+
+std::unique_ptr<SnakePolicy> createPolicy(PolicyKind kind, uint64_t seed, int budgetMicros) {
+    switch (kind) {
+        case POLICY_AUTOPILOT:
+            return std::unique_ptr<SnakePolicy>(new AutopilotPolicy(seed, budgetMicros));
+        case POLICY_GREEDY:
+            break;
+    }
+    return std::unique_ptr<SnakePolicy>(new GreedyPolicy(seed));
+}
+
+bool parsePolicyKind(const char* name, PolicyKind& kind) {
+    if (strcmp(name, "greedy") == 0) {
+        kind = POLICY_GREEDY;
+        return true;
+    }
+    if (strcmp(name, "autopilot") == 0) {
+        kind = POLICY_AUTOPILOT;
+        return true;
+    }
+    return false;
+}
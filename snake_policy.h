@@ -0,0 +1,42 @@
+// Automated players for headless games.
+//
+// A SnakePolicy picks the direction to pass to SnakeEngine::step() each
+// tick. Policies may keep state between ticks, so each running game needs
+// its own instance; use createPolicy() to make one.
+
+#ifndef SNAKE_POLICY_H
+#define SNAKE_POLICY_H
+
+#include <cstdint>
+#include <memory>
+
+#include "snake_engine.h"
+
+enum PolicyKind {
+    POLICY_GREEDY,    // Head for the food by the shortest safe step with room for the body
+    POLICY_AUTOPILOT  // Path-find to the food, keep the tail reachable, pack full boards
+};
+
+class SnakePolicy {
+public:
+    virtual ~SnakePolicy() {}
+
+    // Called after the engine has been reset or loaded with a new game
+    virtual void newGame(const SnakeEngine& engine) = 0;
+    // Direction for the next step()
+    virtual Direction choose(const SnakeEngine& engine) = 0;
+};
+
+// `seed` drives any tie-breaking, so the same seed and game replay identically.
+// `budgetMicros` caps the planning time of one choose() call; when it runs
+// out the policy settles for a cheap safe move. 0 means no limit, which keeps
+// choices independent of machine speed.
+std::unique_ptr<SnakePolicy> createPolicy(PolicyKind kind, uint64_t seed, int budgetMicros = 0);
+
+// Parse a policy name ("greedy", "autopilot"); false if unknown
+bool parsePolicyKind(const char* name, PolicyKind& kind);
+
+// True if stepping the head in `d` this tick does not end the game
+bool isSafeMove(const SnakeEngine& engine, Direction d);
+
+#endif // SNAKE_POLICY_H
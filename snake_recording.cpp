@@ -0,0 +1,431 @@
+#include "snake_recording.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char RECORDING_MAGIC[8] = {'C', 'S', 'N', 'K', 'R', 'E', 'C', '2'};
+const char RECORDING_MAGIC_V1[8] = {'C', 'S', 'N', 'K', 'R', 'E', 'C', '1'};
+const char INDEX_MAGIC[8] = {'C', 'S', 'N', 'K', 'I', 'D', 'X', '2'};
+const unsigned char GAME_MARKER = 0xFF;
+const unsigned char KEYFRAME_MARKER = 0xFE;
+const unsigned char INDEX_MARKER = 0xFD;
+const int MAX_RUN = 32;
+const size_t GAME_HEADER_SIZE = 1 + 4 + 4 + 8;
+const size_t KEYFRAME_FIXED_SIZE = 8 + 4 + 4 + 1 + 1 + 4 + 4 + 8 + 4;  // Before the body words
+const int SHORT_CELL_LIMIT = 1 << 16;  // Boards up to this many cells store free cells as u16
+const size_t TRAILER_SIZE = 8 + sizeof(INDEX_MAGIC);
+
+uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+int freeCellBytes(int width, int height) {
+    return static_cast<long long>(width) * height <= SHORT_CELL_LIMIT ? 2 : 4;
+}
+
+} // namespace
+
+InputRecorder::InputRecorder()
+    : file(nullptr),
+      written(0),
+      runDirection(NONE),
+      runLength(0),
+      ticks(0),
+      nextKeyframe(KEYFRAME_TICKS) {
+}
+
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+bool InputRecorder::open(const std::string& path) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    fwrite(RECORDING_MAGIC, 1, sizeof(RECORDING_MAGIC), file);
+    written = sizeof(RECORDING_MAGIC);
+    games.clear();
+    return true;
+}
+
+void InputRecorder::put(uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        fputc(static_cast<int>((value >> (8 * i)) & 0xFF), file);
+    }
+    written += bytes;
+}
+
+void InputRecorder::close() {
+    if (!file) return;
+    endGame();
+
+    uint64_t indexOffset = written;
+    put(INDEX_MARKER, 1);
+    put(games.size(), 4);
+    for (size_t i = 0; i < games.size(); ++i) {
+        const RecordedGame& game = games[i];
+        put(game.offset, 8);
+        put(game.end, 8);
+        put(static_cast<uint64_t>(game.ticks), 8);
+        put(game.keyframeTicks.size(), 4);
+        for (size_t k = 0; k < game.keyframeTicks.size(); ++k) {
+            put(static_cast<uint64_t>(game.keyframeTicks[k]), 8);
+            put(game.keyframeOffsets[k], 8);
+        }
+    }
+    put(indexOffset, 8);
+    fwrite(INDEX_MAGIC, 1, sizeof(INDEX_MAGIC), file);
+
+    fclose(file);
+    file = nullptr;
+    games.clear();
+}
+
+void InputRecorder::flushRun() {
+    if (runLength == 0) return;
+    put((static_cast<int>(runDirection) << 5) | (runLength - 1), 1);
+    runLength = 0;
+}
+
+// Close off the current game's index entry
+void InputRecorder::endGame() {
+    flushRun();
+    if (!games.empty()) {
+        games.back().end = written;
+        games.back().ticks = ticks;
+    }
+}
+
+void InputRecorder::beginGame(int width, int height, uint64_t seed) {
+    if (!file) return;
+    endGame();
+    RecordedGame game;
+    game.offset = written;
+    game.end = written;
+    game.ticks = 0;
+    game.width = width;
+    game.height = height;
+    game.seed = seed;
+    games.push_back(game);
+    ticks = 0;
+    nextKeyframe = KEYFRAME_TICKS;
+
+    put(GAME_MARKER, 1);
+    put(static_cast<uint32_t>(width), 4);
+    put(static_cast<uint32_t>(height), 4);
+    put(seed, 8);
+}
+
+void InputRecorder::writeKeyframe(const SnakeEngine& engine) {
+    flushRun();
+    // The free-list order too, or food after a seek would land elsewhere
+    engine.saveState(snapshot, true);
+    snapshot.body.save(bodyWords);
+    int cellBytes = freeCellBytes(engine.width(), engine.height());
+    size_t payload = KEYFRAME_FIXED_SIZE + bodyWords.size() * 8 + snapshot.freeOrder.size() * cellBytes;
+
+    games.back().keyframeTicks.push_back(ticks);
+    games.back().keyframeOffsets.push_back(written);
+    put(KEYFRAME_MARKER, 1);
+    put(payload, 4);
+    put(static_cast<uint64_t>(ticks), 8);
+    put(static_cast<uint32_t>(snapshot.food.x), 4);
+    put(static_cast<uint32_t>(snapshot.food.y), 4);
+    put(snapshot.direction, 1);
+    put(snapshot.endReason, 1);
+    put(static_cast<uint32_t>(snapshot.score), 4);
+    put(static_cast<uint32_t>(snapshot.speed), 4);
+    put(snapshot.rngState, 8);
+    put(bodyWords.size(), 4);
+    for (size_t i = 0; i < bodyWords.size(); ++i) {
+        put(bodyWords[i], 8);
+    }
+    for (size_t i = 0; i < snapshot.freeOrder.size(); ++i) {
+        put(static_cast<uint32_t>(snapshot.freeOrder[i]), cellBytes);
+    }
+    nextKeyframe = ticks + std::max<long long>(KEYFRAME_TICKS, static_cast<long long>(payload));
+}
+
+void InputRecorder::record(Direction requested, const SnakeEngine& engine) {
+    if (!file) return;
+    if (ticks == nextKeyframe && !games.empty()) {
+        writeKeyframe(engine);
+    }
+    if (runLength > 0 && (requested != runDirection || runLength == MAX_RUN)) {
+        flushRun();
+    }
+    runDirection = requested;
+    runLength++;
+    ticks++;
+}
+
+InputReplay::InputReplay()
+    : data(nullptr),
+      size(0),
+      currentGame(-1),
+      pos(0),
+      end(0),
+      currentTick(0),
+      runDirection(NONE),
+      runRemaining(0) {
+}
+
+InputReplay::~InputReplay() {
+    close();
+}
+
+void InputReplay::close() {
+    data = nullptr;
+    size = 0;
+    index.clear();
+    currentGame = -1;
+    pos = end = 0;
+    currentTick = 0;
+    runRemaining = 0;
+}
+
+bool InputReplay::open(const unsigned char* bytes, size_t length) {
+    close();
+    if (!bytes || length < sizeof(RECORDING_MAGIC)) {
+        return false;
+    }
+    data = bytes;
+    size = length;
+
+    bool indexed = false;
+    if (memcmp(data, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) == 0) {
+        indexed = readIndex() || scanIndex(sizeof(RECORDING_MAGIC));
+    } else if (memcmp(data, RECORDING_MAGIC_V1, sizeof(RECORDING_MAGIC_V1)) == 0) {
+        indexed = scanIndex(sizeof(RECORDING_MAGIC_V1));
+    }
+    if (!indexed) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Load the index the recorder wrote at the end; false if it is missing or
+// does not match the file
+bool InputReplay::readIndex() {
+    if (size < sizeof(RECORDING_MAGIC) + TRAILER_SIZE ||
+        memcmp(data + size - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+    uint64_t at = getLE(data + size - TRAILER_SIZE, 8);
+    size_t limit = size - TRAILER_SIZE;
+    if (at >= limit || limit - at < 5 || data[at] != INDEX_MARKER) {
+        return false;
+    }
+    uint64_t count = getLE(data + at + 1, 4);
+    at += 5;
+    index.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        if (limit - at < 28) return false;
+        RecordedGame game;
+        game.offset = getLE(data + at, 8);
+        game.end = getLE(data + at + 8, 8);
+        game.ticks = static_cast<long long>(getLE(data + at + 16, 8));
+        uint64_t keyframes = getLE(data + at + 24, 4);
+        at += 28;
+        if (game.offset >= game.end || game.end > limit || game.end - game.offset < GAME_HEADER_SIZE ||
+            data[game.offset] != GAME_MARKER || (limit - at) / 16 < keyframes) {
+            return false;
+        }
+        const unsigned char* header = data + game.offset + 1;
+        game.width = static_cast<int>(getLE(header, 4));
+        game.height = static_cast<int>(getLE(header + 4, 4));
+        game.seed = getLE(header + 8, 8);
+        for (uint64_t k = 0; k < keyframes; ++k) {
+            long long tick = static_cast<long long>(getLE(data + at, 8));
+            uint64_t offset = getLE(data + at + 8, 8);
+            at += 16;
+            if (offset < game.offset || offset >= game.end || data[offset] != KEYFRAME_MARKER ||
+                (!game.keyframeTicks.empty() && tick <= game.keyframeTicks.back())) {
+                return false;
+            }
+            game.keyframeTicks.push_back(tick);
+            game.keyframeOffsets.push_back(offset);
+        }
+        index.push_back(game);
+    }
+    return true;
+}
+
+// Build the index by walking every byte once; false if the file is malformed
+// before its first game
+bool InputReplay::scanIndex(size_t start) {
+    index.clear();
+    size_t at = start;
+    while (at < size) {
+        unsigned char byte = data[at];
+        if (byte == GAME_MARKER) {
+            if (!index.empty()) index.back().end = at;
+            if (size - at < GAME_HEADER_SIZE) break;
+            RecordedGame game;
+            game.offset = at;
+            game.end = size;
+            game.ticks = 0;
+            game.width = static_cast<int>(getLE(data + at + 1, 4));
+            game.height = static_cast<int>(getLE(data + at + 5, 4));
+            game.seed = getLE(data + at + 9, 8);
+            index.push_back(game);
+            at += GAME_HEADER_SIZE;
+        } else if (byte == KEYFRAME_MARKER && !index.empty()) {
+            if (size - at < 5) break;
+            uint64_t payload = getLE(data + at + 1, 4);
+            if (payload < KEYFRAME_FIXED_SIZE || size - at - 5 < payload) break;
+            RecordedGame& game = index.back();
+            long long tick = static_cast<long long>(getLE(data + at + 5, 8));
+            if (tick == game.ticks) {
+                game.keyframeTicks.push_back(tick);
+                game.keyframeOffsets.push_back(at);
+            }
+            at += 5 + payload;
+        } else if ((byte >> 5) <= NONE && !index.empty()) {
+            index.back().ticks += (byte & 0x1F) + 1;
+            at++;
+        } else {
+            break;  // The index, or damage; either way the games end here
+        }
+    }
+    if (!index.empty() && index.back().end > at) {
+        index.back().end = at;
+    }
+    return at > start || size == start;
+}
+
+bool InputReplay::nextGame(int& width, int& height, uint64_t& seed) {
+    runRemaining = 0;
+    currentTick = 0;
+    if (currentGame + 1 >= static_cast<long long>(index.size())) {
+        currentGame = static_cast<long long>(index.size());
+        pos = end = 0;
+        return false;
+    }
+    const RecordedGame& game = index[static_cast<size_t>(++currentGame)];
+    width = game.width;
+    height = game.height;
+    seed = game.seed;
+    pos = static_cast<size_t>(game.offset) + GAME_HEADER_SIZE;
+    end = static_cast<size_t>(game.end);
+    return true;
+}
+
+bool InputReplay::nextInput(Direction& requested) {
+    if (runRemaining == 0) {
+        // Keyframes only matter when seeking
+        while (pos < end && data[pos] == KEYFRAME_MARKER && end - pos >= 5) {
+            pos += 5 + static_cast<size_t>(getLE(data + pos + 1, 4));
+        }
+        if (pos >= end) {
+            return false;
+        }
+        unsigned char byte = data[pos++];
+        int direction = byte >> 5;
+        if (direction > NONE) {
+            pos = end;
+            return false;
+        }
+        runDirection = static_cast<Direction>(direction);
+        runRemaining = (byte & 0x1F) + 1;
+    }
+    runRemaining--;
+    currentTick++;
+    requested = runDirection;
+    return true;
+}
+
+long long InputReplay::gameTicks() const {
+    if (currentGame < 0 || currentGame >= static_cast<long long>(index.size())) return 0;
+    return index[static_cast<size_t>(currentGame)].ticks;
+}
+
+bool InputReplay::loadKeyframe(SnakeEngine& engine, const RecordedGame& game, uint64_t offset) {
+    const unsigned char* p = data + offset + 5;
+    size_t payload = static_cast<size_t>(getLE(data + offset + 1, 4));
+    if (game.end - offset < 5 || payload > game.end - offset - 5 || payload < KEYFRAME_FIXED_SIZE) {
+        return false;
+    }
+    size_t words = static_cast<size_t>(getLE(p + 34, 4));
+    size_t cellBytes = static_cast<size_t>(freeCellBytes(game.width, game.height));
+    if (words > (payload - KEYFRAME_FIXED_SIZE) / 8 ||
+        (payload - KEYFRAME_FIXED_SIZE - words * 8) % cellBytes != 0) {
+        return false;
+    }
+    bodyWords.resize(words);
+    for (size_t i = 0; i < words; ++i) {
+        bodyWords[i] = getLE(p + KEYFRAME_FIXED_SIZE + i * 8, 8);
+    }
+    if (!snapshot.body.load(bodyWords.data(), words)) {
+        return false;
+    }
+    const unsigned char* freeCells = p + KEYFRAME_FIXED_SIZE + words * 8;
+    snapshot.freeOrder.resize((payload - KEYFRAME_FIXED_SIZE - words * 8) / cellBytes);
+    for (size_t i = 0; i < snapshot.freeOrder.size(); ++i) {
+        snapshot.freeOrder[i] = static_cast<int>(getLE(freeCells + i * cellBytes, static_cast<int>(cellBytes)));
+    }
+    snapshot.width = game.width;
+    snapshot.height = game.height;
+    snapshot.food.x = static_cast<int>(static_cast<uint32_t>(getLE(p + 8, 4)));
+    snapshot.food.y = static_cast<int>(static_cast<uint32_t>(getLE(p + 12, 4)));
+    if (p[16] > NONE || p[17] > END_BOARD_FULL) {
+        return false;
+    }
+    snapshot.direction = static_cast<Direction>(p[16]);
+    snapshot.endReason = static_cast<EndReason>(p[17]);
+    snapshot.score = static_cast<int>(static_cast<uint32_t>(getLE(p + 18, 4)));
+    snapshot.speed = static_cast<int>(static_cast<uint32_t>(getLE(p + 22, 4)));
+    snapshot.seed = game.seed;
+    snapshot.rngState = getLE(p + 26, 8);
+    if (!engine.loadState(snapshot)) {
+        return false;
+    }
+    pos = static_cast<size_t>(offset) + 5 + payload;
+    currentTick = static_cast<long long>(getLE(p, 8));
+    runRemaining = 0;
+    return true;
+}
+
+bool InputReplay::seek(SnakeEngine& engine, long long target) {
+    if (currentGame < 0 || currentGame >= static_cast<long long>(index.size()) ||
+        target < 0 || target > gameTicks()) {
+        return false;
+    }
+    const RecordedGame& game = index[static_cast<size_t>(currentGame)];
+
+    // Last keyframe at or before the target
+    std::vector<long long>::const_iterator key =
+        std::upper_bound(game.keyframeTicks.begin(), game.keyframeTicks.end(), target);
+    long long keyTick = 0;
+    if (key != game.keyframeTicks.begin()) {
+        keyTick = *(key - 1);
+    }
+    if (target < currentTick || keyTick > currentTick) {
+        if (keyTick > 0) {
+            size_t k = static_cast<size_t>(key - game.keyframeTicks.begin()) - 1;
+            if (!loadKeyframe(engine, game, game.keyframeOffsets[k])) {
+                return false;
+            }
+        } else {
+            engine.reset(game.width, game.height, game.seed);
+            pos = static_cast<size_t>(game.offset) + GAME_HEADER_SIZE;
+            currentTick = 0;
+            runRemaining = 0;
+        }
+    }
+
+    Direction input;
+    while (currentTick < target && nextInput(input)) {
+        engine.step(input);
+    }
+    return currentTick == target;
+}
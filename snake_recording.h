@@ -0,0 +1,145 @@
+// Compact binary recording of game inputs, with keyframes for seeking.
+//
+// A recording is enough to reproduce a session bit for bit: each game stores
+// its board size and RNG seed, followed by the direction passed to every
+// SnakeEngine::step() call. Every so often it also stores a keyframe, the
+// full engine state, and the file ends with an index of games and
+// keyframes, so a player can jump to any tick of a long game by loading the
+// nearest keyframe and simulating forward from there.
+//
+// File layout (all integers little-endian):
+//   "CSNKREC2"                          8-byte magic and format version
+//   per game:
+//     0xFF u32 width u32 height u64 seed  game header
+//     input bytes                         (direction << 5) | (run length - 1)
+//     0xFE u32 size, then size bytes:     keyframe, between input bytes
+//       u64 tick                          steps taken before this state
+//       i32 foodX i32 foodY u8 direction u8 endReason
+//       i32 score i32 speed u64 rngState u32 bodyWords
+//       u64 words...                      SnakeBody::save() snapshot
+//       free cells...                     Free-list order, u16 each (u32 on
+//                                         boards over 65536 cells); none on
+//                                         large boards
+//   0xFD u32 games, then per game:        index
+//     u64 offset u64 end u64 ticks u32 keyframes, then per keyframe:
+//       u64 tick u64 offset
+//   u64 index offset "CSNKIDX2"           trailer
+//
+// Consecutive identical inputs are run-length encoded, up to 32 ticks per
+// byte, so a long straight run costs a few bytes. A file without a valid
+// trailer, such as one left by a crash or a version 1 file ("CSNKREC1", no
+// keyframes), is indexed by scanning it once when opened.
+
+#ifndef SNAKE_RECORDING_H
+#define SNAKE_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "snake_engine.h"
+
+// Where one game and its keyframes sit in a recording
+struct RecordedGame {
+    uint64_t offset;           // Game header
+    uint64_t end;              // First byte after the game
+    long long ticks;           // Inputs recorded
+    int width;
+    int height;
+    uint64_t seed;
+    std::vector<long long> keyframeTicks;
+    std::vector<uint64_t> keyframeOffsets;
+};
+
+class InputRecorder {
+public:
+    // Ticks between keyframes; longer when keyframes are large, so they stay
+    // within about a byte per tick
+    static const int KEYFRAME_TICKS = 4096;
+
+    InputRecorder();
+    ~InputRecorder();
+
+    bool open(const std::string& path);
+    bool isOpen() const { return file != nullptr; }
+    // Write the index and close; recordings that are never closed still
+    // play, but are indexed by scanning
+    void close();
+
+    void beginGame(int width, int height, uint64_t seed);
+    // Log the direction passed to the next SnakeEngine::step() call;
+    // `engine` is the state before that step, kept when a keyframe is due
+    void record(Direction requested, const SnakeEngine& engine);
+
+private:
+    FILE* file;
+    uint64_t written;          // Bytes written so far
+    Direction runDirection;
+    int runLength;
+    long long ticks;           // Inputs recorded in the current game
+    long long nextKeyframe;
+    std::vector<RecordedGame> games;
+    EngineState snapshot;      // Reused keyframe scratch space
+    std::vector<uint64_t> bodyWords;
+
+    void put(uint64_t value, int bytes);
+    void flushRun();
+    void endGame();
+    void writeKeyframe(const SnakeEngine& engine);
+
+    InputRecorder(const InputRecorder&);
+    InputRecorder& operator=(const InputRecorder&);
+};
+
+class InputReplay {
+public:
+    InputReplay();
+    ~InputReplay();
+
+    // Index a recording held in memory, usually a file mapped by the
+    // caller; false if malformed. `data` must outlive the replay or the next
+    // open()/close().
+    bool open(const unsigned char* data, size_t size);
+    void close();
+
+    const std::vector<RecordedGame>& games() const { return index; }
+
+    // Advance to the next recorded game; false when there are no more
+    bool nextGame(int& width, int& height, uint64_t& seed);
+    // Next recorded step() input of the current game; false when exhausted
+    bool nextInput(Direction& requested);
+
+    // Inputs read so far in the current game, and how many it has
+    long long tick() const { return currentTick; }
+    long long gameTicks() const;
+
+    // Bring `engine`, which is playing the current game, to tick `target`:
+    // load the last keyframe at or before it (or restart the game) unless
+    // simulating on from the engine's tick is shorter, then step forward.
+    // False if the game has fewer ticks or a keyframe does not load.
+    bool seek(SnakeEngine& engine, long long target);
+
+private:
+    const unsigned char* data;
+    size_t size;
+    std::vector<RecordedGame> index;
+    long long currentGame;     // Index entry being played, -1 before the first
+    size_t pos;
+    size_t end;                // End of the current game's bytes
+    long long currentTick;
+    Direction runDirection;
+    int runRemaining;
+    EngineState snapshot;
+    std::vector<uint64_t> bodyWords;
+
+    bool readIndex();
+    bool scanIndex(size_t start);
+    bool loadKeyframe(SnakeEngine& engine, const RecordedGame& game, uint64_t offset);
+
+    InputReplay(const InputReplay&);
+    InputReplay& operator=(const InputReplay&);
+};
+
+#endif // SNAKE_RECORDING_H
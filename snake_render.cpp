@@ -0,0 +1,383 @@
+#include "snake_render.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Text styles ("pens"): the low three bits pick the foreground colour as an
+// offset from SGR 30, with 0 meaning the terminal's default, plus attributes
+const unsigned char PEN_PLAIN = 0;
+const unsigned char PEN_RED = 1;
+const unsigned char PEN_GREEN = 2;
+const unsigned char PEN_YELLOW = 3;
+const unsigned char PEN_MAGENTA = 5;
+const unsigned char PEN_CYAN = 6;
+const unsigned char PEN_WHITE = 7;
+const unsigned char PEN_COLOUR = 7;
+const unsigned char PEN_BOLD = 8;
+const unsigned char PEN_DIM = 16;
+const unsigned char PEN_UNKNOWN = 0xFF;  // Whatever the terminal was left in
+const unsigned char PEN_ANY = 0xFE;      // The glyph looks the same in every style
+
+struct CellLook {
+    unsigned char pen;
+    const char* glyph;
+};
+
+// How each CellKind is drawn
+const CellLook CELL_LOOKS[] = {
+    { PEN_ANY, " " },
+    { PEN_RED, "●" },
+    { PEN_GREEN, "■" },
+    { PEN_GREEN | PEN_BOLD, "◆" }
+};
+
+// Append the shortest SGR sequence that takes the terminal from style `from`
+// to style `to`. Bold and dim can only be dropped together (SGR 22) or with a
+// full reset, so dropping either one resets.
+void appendPenChange(std::string& out, unsigned char from, unsigned char to) {
+    if (from == to) return;
+    char seq[24] = "\033[";
+    size_t length = 2;
+    if (from == PEN_UNKNOWN || (from & ~to & (PEN_BOLD | PEN_DIM)) != 0) {
+        seq[length++] = '0';
+        from = PEN_PLAIN;
+    }
+    if ((to & PEN_BOLD) && !(from & PEN_BOLD)) {
+        if (length > 2) seq[length++] = ';';
+        seq[length++] = '1';
+    }
+    if ((to & PEN_DIM) && !(from & PEN_DIM)) {
+        if (length > 2) seq[length++] = ';';
+        seq[length++] = '2';
+    }
+    if ((to & PEN_COLOUR) != (from & PEN_COLOUR)) {
+        if (length > 2) seq[length++] = ';';
+        seq[length++] = '3';
+        seq[length++] = (to & PEN_COLOUR) ? static_cast<char>('0' + (to & PEN_COLOUR)) : '9';
+    }
+    seq[length++] = 'm';
+    out.append(seq, length);
+}
+
+void appendNumber(std::string& out, int value) {
+    char digits[16];
+    int length = snprintf(digits, sizeof(digits), "%d", value);
+    out.append(digits, static_cast<size_t>(length));
+}
+
+void appendRepeat(std::string& out, const char* glyph, int count) {
+    for (int i = 0; i < count; ++i) out += glyph;
+}
+
+void appendCursor(std::string& out, int row, int col) {
+    char seq[32];
+    snprintf(seq, sizeof(seq), "\033[%d;%dH", row, col);
+    out += seq;
+}
+
+// Camera offset on one axis: unchanged while the head stays a quarter view
+// away from the edges, otherwise recentred, and always inside the board
+int followAxis(int camera, int head, int view, int board) {
+    int margin = view / 4;
+    if (head < camera + margin || head >= camera + view - margin) {
+        camera = head - view / 2;
+    }
+    return std::max(0, std::min(camera, board - view));
+}
+
+} // namespace
+
+FrameRenderer::FrameRenderer()
+    : hudStatusChanged(false),
+      deltaMode(true),
+      frameInvalid(true),
+      keepChanges(false),
+      lastFull(false),
+      viewMaxWidth(0),
+      viewMaxHeight(0),
+      boardWidth(0),
+      boardHeight(0),
+      shownWidth(0),
+      shownHeight(0),
+      cameraX(0),
+      cameraY(0),
+      shownScore(0),
+      shownSpeed(0),
+      shownPaused(false),
+      pen(PEN_UNKNOWN),
+      layoutWidth(-1) {
+}
+
+// Switch the terminal to `style` for the text that follows
+void FrameRenderer::setPen(unsigned char style) {
+    appendPenChange(buffer, pen, style);
+    pen = style;
+}
+
+void FrameRenderer::setDeltaRendering(bool enabled) {
+    deltaMode = enabled;
+    frameInvalid = true;
+}
+
+void FrameRenderer::setWarning(const std::string& message) {
+    if (message != warning) {
+        warning = message;
+        frameInvalid = true;
+    }
+}
+
+void FrameRenderer::setViewport(int maxWidth, int maxHeight) {
+    if (maxWidth != viewMaxWidth || maxHeight != viewMaxHeight) {
+        viewMaxWidth = std::max(maxWidth, 0);
+        viewMaxHeight = std::max(maxHeight, 0);
+        frameInvalid = true;
+    }
+}
+
+void FrameRenderer::setHudStatus(const std::string& status) {
+    if (status != hudStatus) {
+        hudStatus = status;
+        hudStatusChanged = true;
+    }
+}
+
+bool FrameRenderer::compose(SnakeEngine& engine, bool paused) {
+    if (!deltaMode || frameInvalid ||
+        engine.width() != boardWidth || engine.height() != boardHeight) {
+        composeFull(engine, paused);
+        lastFull = true;
+    } else {
+        composeDelta(engine, paused);
+        lastFull = false;
+    }
+    return !buffer.empty();
+}
+
+void FrameRenderer::appendHud(const SnakeEngine& engine) {
+    int displaySpeed = std::max(0, INITIAL_SPEED - engine.speed() + 50);
+    buffer += "  ";
+    setPen(PEN_GREEN);
+    buffer += "Score: ";
+    setPen(PEN_GREEN | PEN_BOLD);
+    appendNumber(buffer, engine.score());
+    buffer += "  ";
+    setPen(PEN_MAGENTA);
+    buffer += "Speed: ";
+    setPen(PEN_MAGENTA | PEN_BOLD);
+    appendNumber(buffer, displaySpeed);
+    if (shownWidth < boardWidth || shownHeight < boardHeight) {
+        // Scrolling world: the food may be off screen, so give coordinates
+        char coords[64];
+        setPen(PEN_CYAN);
+        snprintf(coords, sizeof(coords), "  @%d,%d  ", engine.head().x, engine.head().y);
+        buffer += coords;
+        setPen(PEN_RED);
+        snprintf(coords, sizeof(coords), "●%d,%d", engine.food().x, engine.food().y);
+        buffer += coords;
+    }
+    if (!hudStatus.empty()) {
+        buffer += "  ";
+        setPen(PEN_DIM);
+        buffer += hudStatus;
+    }
+    hudStatusChanged = false;
+}
+
+void FrameRenderer::appendControls(bool paused) {
+    buffer += "  ";
+    if (paused) {
+        setPen(PEN_YELLOW | PEN_BOLD);
+        buffer += "⏸  PAUSED - Press SPACE to resume";
+    } else {
+        setPen(PEN_WHITE);
+        buffer += "Controls: WASD or Arrow Keys | SPACE to pause | Q to quit";
+    }
+}
+
+// Follow the head; true if the viewport now shows different board cells
+bool FrameRenderer::moveCamera(const SnakeEngine& engine) {
+    int x = followAxis(cameraX, engine.head().x, shownWidth, boardWidth);
+    int y = followAxis(cameraY, engine.head().y, shownHeight, boardHeight);
+    bool moved = x != cameraX || y != cameraY;
+    cameraX = x;
+    cameraY = y;
+    return moved;
+}
+
+void FrameRenderer::appendCell(unsigned char kind) {
+    const CellLook& look = CELL_LOOKS[kind];
+    if (look.pen != PEN_ANY) setPen(look.pen);
+    buffer += look.glyph;
+}
+
+// Append one viewport row's glyphs and remember them as shown
+void FrameRenderer::appendViewRow(const SnakeEngine& engine, int row) {
+    unsigned char* shown = &shownCells[static_cast<size_t>(row) * shownWidth];
+    for (int x = 0; x < shownWidth; ++x) {
+        unsigned char kind = engine.cellAt(cameraX + x, cameraY + row);
+        shown[x] = kind;
+        appendCell(kind);
+    }
+}
+
+// Build the parts of a full frame that depend only on the viewport width,
+// composing the title in `buffer` so it gets the same style changes
+void FrameRenderer::layOut() {
+    layoutWidth = shownWidth;
+    buffer.clear();
+    pen = PEN_UNKNOWN;
+
+    setPen(PEN_CYAN | PEN_BOLD);
+    buffer += "╔";
+    appendRepeat(buffer, "═", layoutWidth + 2);
+    buffer += "╗\n";
+
+    buffer += "║";
+    int titlePad = (layoutWidth + 2 - 16) / 2;  // 16 = length of "C++ SNAKE GAME"
+    appendRepeat(buffer, " ", titlePad);
+    setPen(PEN_YELLOW | PEN_BOLD);
+    buffer += "C++ SNAKE GAME";
+    setPen(PEN_CYAN | PEN_BOLD);
+    appendRepeat(buffer, " ", layoutWidth + 2 - 16 - titlePad);
+    buffer += "║\n";
+
+    buffer += "╚";
+    appendRepeat(buffer, "═", layoutWidth + 2);
+    buffer += "╝\n";
+    layoutTitle.swap(buffer);
+
+    layoutTop = "┌";
+    appendRepeat(layoutTop, "─", layoutWidth);
+    layoutTop += "┐\n";
+    layoutBottom = "└";
+    appendRepeat(layoutBottom, "─", layoutWidth);
+    layoutBottom += "┘\n";
+}
+
+void FrameRenderer::composeFull(SnakeEngine& engine, bool paused) {
+    boardWidth = engine.width();
+    boardHeight = engine.height();
+    shownWidth = viewMaxWidth > 0 ? std::min(boardWidth, viewMaxWidth) : boardWidth;
+    shownHeight = viewMaxHeight > 0 ? std::min(boardHeight, viewMaxHeight) : boardHeight;
+    shownCells.assign(static_cast<size_t>(shownWidth) * shownHeight, CELL_EMPTY);
+    moveCamera(engine);
+    shownHead = engine.head();
+
+    if (shownWidth != layoutWidth) {
+        layOut();
+    }
+
+    buffer.clear();
+    // Worst case is every cell needing its own colour change
+    buffer.reserve(layoutTitle.size() + static_cast<size_t>(shownWidth + 8) * (shownHeight + 8) * 12);
+
+    // Just home cursor - we're in alternate buffer so no scrolling. The
+    // title leaves the style bold cyan whatever it started in.
+    buffer += "\033[H";
+    buffer += layoutTitle;
+    pen = PEN_CYAN | PEN_BOLD;
+
+    // HUD
+    appendHud(engine);
+    buffer += "\033[K\n";
+
+    if (!warning.empty()) {
+        buffer += "  ";
+        setPen(PEN_YELLOW);
+        buffer += warning;
+        buffer += "\n";
+    }
+
+    // Top border
+    buffer += "  ";
+    setPen(PEN_CYAN);
+    buffer += layoutTop;
+
+    // Game board, one glyph lookup per cell
+    for (int y = 0; y < shownHeight; ++y) {
+        buffer += "  ";
+        setPen(PEN_CYAN);
+        buffer += "│";
+        appendViewRow(engine, y);
+        setPen(PEN_CYAN);
+        buffer += "│\n";
+    }
+
+    // Bottom border
+    buffer += "  ";
+    setPen(PEN_CYAN);
+    buffer += layoutBottom;
+
+    // Controls
+    appendControls(paused);
+    setPen(PEN_PLAIN);
+    buffer += "\033[K";
+
+    // Remember what is on screen for subsequent delta frames
+    if (!keepChanges) engine.clearChanges();
+    shownScore = engine.score();
+    shownSpeed = engine.speed();
+    shownPaused = paused;
+    frameInvalid = false;
+}
+
+void FrameRenderer::appendCellIfChanged(const SnakeEngine& engine, int x, int y) {
+    int viewX = x - cameraX;
+    int viewY = y - cameraY;
+    if (viewX < 0 || viewX >= shownWidth || viewY < 0 || viewY >= shownHeight) return;
+    unsigned char kind = engine.cellAt(x, y);
+    unsigned char& shown = shownCells[static_cast<size_t>(viewY) * shownWidth + viewX];
+    if (kind == shown) return;  // Unchanged, or changed and changed back
+    shown = kind;
+    appendCursor(buffer, boardRow() + viewY, 4 + viewX);
+    appendCell(kind);
+}
+
+// Emit cursor moves and glyphs only for cells and HUD fields that differ
+// from the last presented frame
+void FrameRenderer::composeDelta(SnakeEngine& engine, bool paused) {
+    buffer.clear();
+    pen = PEN_PLAIN;  // Every frame leaves the terminal in its default style
+
+    if (moveCamera(engine)) {
+        // The view scrolled; repaint its rows, one cursor move each
+        for (int y = 0; y < shownHeight; ++y) {
+            appendCursor(buffer, boardRow() + y, 4);
+            appendViewRow(engine, y);
+        }
+    } else if (!engine.changeTracking() || engine.changesOverflowed()) {
+        // No usable change list; compare every visible cell
+        for (int y = 0; y < shownHeight; ++y) {
+            for (int x = 0; x < shownWidth; ++x) {
+                appendCellIfChanged(engine, cameraX + x, cameraY + y);
+            }
+        }
+    } else {
+        const std::vector<int>& changed = engine.changedCells();
+        for (size_t i = 0; i < changed.size(); ++i) {
+            appendCellIfChanged(engine, changed[i] % boardWidth, changed[i] / boardWidth);
+        }
+    }
+    if (!keepChanges) engine.clearChanges();
+
+    bool headMoved = engine.head() != shownHead &&
+                     (shownWidth < boardWidth || shownHeight < boardHeight);
+    shownHead = engine.head();
+    if (engine.score() != shownScore || engine.speed() != shownSpeed || hudStatusChanged || headMoved) {
+        appendCursor(buffer, hudRow(), 1);
+        appendHud(engine);
+        buffer += "\033[K";
+        shownScore = engine.score();
+        shownSpeed = engine.speed();
+    }
+
+    if (paused != shownPaused) {
+        appendCursor(buffer, controlsRow(), 1);
+        appendControls(paused);
+        buffer += "\033[K";
+        shownPaused = paused;
+    }
+    setPen(PEN_PLAIN);
+}
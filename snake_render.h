@@ -0,0 +1,108 @@
+// ANSI frame composition for the terminal frontend.
+//
+// FrameRenderer turns SnakeEngine state into the bytes that draw it: a full
+// repaint, or after one, only the cells and HUD fields that changed. It
+// performs no I/O itself, so the same frames can go to a terminal, a socket
+// or a benchmark's null sink.
+//
+// Boards larger than the viewport are shown through a camera that follows
+// the head, so a frame costs O(viewport) however large the world is.
+//
+// Colours and attributes are tracked as the frame is composed, so an escape
+// sequence is only emitted where the style actually changes: a run of snake
+// cells or a wall row shares one colour code. Every frame leaves the
+// terminal in its default style, so frames can be dropped or sent to a
+// client that joined late.
+//
+// A full frame overwrites everything the previous one drew but clears
+// nothing else, so the screen must already be blank or showing a frame of
+// the same layout. After a resize or another screen, clear it first.
+
+#ifndef SNAKE_RENDER_H
+#define SNAKE_RENDER_H
+
+#include <string>
+#include <vector>
+
+#include "snake_engine.h"
+
+class FrameRenderer {
+public:
+    FrameRenderer();
+
+    // Redraw only changed cells between full repaints (default on)
+    void setDeltaRendering(bool enabled);
+    bool deltaRendering() const { return deltaMode; }
+
+    // Line shown under the HUD, e.g. an arena-scaled warning; empty for none
+    void setWarning(const std::string& message);
+
+    // Extra text after Score/Speed on the HUD line, e.g. frame timings
+    void setHudStatus(const std::string& status);
+
+    // Largest board area drawn, in cells; 0 for no limit (the default)
+    void setViewport(int maxWidth, int maxHeight);
+
+    // Force the next compose() to repaint the whole screen
+    void invalidate() { frameInvalid = true; }
+
+    // Leave the engine's change list in place after composing, for when a
+    // second renderer draws the same engine straight afterwards (default off)
+    void setKeepChanges(bool keep) { keepChanges = keep; }
+
+    // Compose the next frame into frame(). Consumes the engine's change list.
+    // Returns false when nothing on screen needs to change.
+    bool compose(SnakeEngine& engine, bool paused);
+    const std::string& frame() const { return buffer; }
+    // The last compose() repainted the whole screen
+    bool fullFrame() const { return lastFull; }
+    // Swap the composed frame into `out` without copying. The renderer keeps
+    // `out`'s old contents as its next buffer, so storage is recycled.
+    void takeFrame(std::string& out) { buffer.swap(out); }
+
+    // Screen rows (1-based) of the HUD line, first board row and controls line
+    int hudRow() const { return 4; }
+    int boardRow() const { return hudRow() + (warning.empty() ? 1 : 2) + 1; }
+    int controlsRow() const { return boardRow() + shownHeight + 1; }
+
+private:
+    std::string buffer;                    // Reused across frames to avoid allocation
+    std::string warning;
+    std::string hudStatus;
+    bool hudStatusChanged;                 // Status differs from what is on screen
+    bool deltaMode;
+    bool frameInvalid;                     // Next compose must be a full repaint
+    bool keepChanges;
+    bool lastFull;
+    std::vector<unsigned char> shownCells; // Viewport CellKinds as last presented on screen
+    int viewMaxWidth;
+    int viewMaxHeight;
+    int boardWidth;                        // Board the viewport was laid out for
+    int boardHeight;
+    int shownWidth;                        // Viewport size on screen
+    int shownHeight;
+    int cameraX;                           // Board cell at the viewport's top-left
+    int cameraY;
+    Point shownHead;
+    int shownScore;
+    int shownSpeed;
+    bool shownPaused;
+    unsigned char pen;                     // Text style the terminal is in at the end of buffer
+    int layoutWidth;                       // Viewport width the strings below were built for
+    std::string layoutTitle;               // Title box, from an unknown style to bold cyan
+    std::string layoutTop;                 // Board borders, without style changes
+    std::string layoutBottom;
+
+    void setPen(unsigned char style);
+    void layOut();
+    bool moveCamera(const SnakeEngine& engine);
+    void composeFull(SnakeEngine& engine, bool paused);
+    void composeDelta(SnakeEngine& engine, bool paused);
+    void appendCell(unsigned char kind);
+    void appendViewRow(const SnakeEngine& engine, int row);
+    void appendCellIfChanged(const SnakeEngine& engine, int x, int y);
+    void appendHud(const SnakeEngine& engine);
+    void appendControls(bool paused);
+};
+
+#endif // SNAKE_RENDER_H
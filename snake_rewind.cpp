@@ -0,0 +1,78 @@
+#include "snake_rewind.h"
+
+#include <algorithm>
+
+RewindBuffer::RewindBuffer(size_t capacity)
+    : ticks(0),
+      count(0) {
+    setCapacity(capacity);
+}
+
+void RewindBuffer::setCapacity(size_t capacity) {
+    undos.assign(capacity, StepUndo());
+    // One spare keyframe so the oldest rewindable tick always has one after it
+    keyframes.assign(capacity > 0 ? capacity / KEYFRAME_INTERVAL + 2 : 0, Keyframe());
+    clear();
+}
+
+void RewindBuffer::clear() {
+    ticks = 0;
+    count = 0;
+    for (size_t i = 0; i < keyframes.size(); ++i) {
+        keyframes[i].tick = -1;
+    }
+}
+
+RewindBuffer::Keyframe* RewindBuffer::keyframeFor(long long tick) {
+    Keyframe& slot = keyframes[static_cast<size_t>(tick / KEYFRAME_INTERVAL) % keyframes.size()];
+    return slot.tick == tick ? &slot : nullptr;
+}
+
+StepResult RewindBuffer::step(SnakeEngine& engine, Direction requested) {
+    if (undos.empty() || engine.isOver()) {
+        return engine.step(requested);
+    }
+    if (ticks % KEYFRAME_INTERVAL == 0) {
+        // Assigning into the slot reuses its body and free-list storage.
+        // Keeping the free-list order makes a rewind through the keyframe
+        // place later food exactly as the original game did.
+        Keyframe& slot = keyframes[static_cast<size_t>(ticks / KEYFRAME_INTERVAL) % keyframes.size()];
+        engine.saveState(slot.state, true);
+        slot.tick = ticks;
+    }
+    StepResult result = engine.step(requested, &undos[static_cast<size_t>(ticks % undos.size())]);
+    ticks++;
+    count = std::min(count + 1, undos.size());
+    return result;
+}
+
+size_t RewindBuffer::rewind(SnakeEngine& engine, size_t requested) {
+    size_t n = std::min(requested, count);
+    if (n == 0) return 0;
+    long long target = ticks - static_cast<long long>(n);
+
+    // Jump to the first keyframe after the target when that skips enough
+    // undos to pay for the reload
+    long long keyTick = (target + KEYFRAME_INTERVAL - 1) / KEYFRAME_INTERVAL * KEYFRAME_INTERVAL;
+    if (ticks - keyTick > KEYFRAME_INTERVAL) {
+        Keyframe* key = keyframeFor(keyTick);
+        if (key && engine.loadState(key->state)) {
+            ticks = keyTick;
+        }
+    }
+    while (ticks > target) {
+        ticks--;
+        engine.undoStep(undos[static_cast<size_t>(ticks % undos.size())]);
+    }
+    count -= n;
+    return n;
+}
+
+size_t RewindBuffer::memoryBytes() const {
+    size_t bytes = undos.capacity() * sizeof(StepUndo) + keyframes.capacity() * sizeof(Keyframe);
+    for (size_t i = 0; i < keyframes.size(); ++i) {
+        bytes += keyframes[i].state.body.memoryBytes() +
+                 keyframes[i].state.freeOrder.capacity() * sizeof(int);
+    }
+    return bytes;
+}
@@ -0,0 +1,60 @@
+// Bounded rewind history for a SnakeEngine.
+//
+// RewindBuffer steps the engine on the caller's behalf and keeps each
+// tick's StepUndo in a fixed-size ring, so history costs the same few dozen
+// bytes per tick on any board and the oldest ticks are forgotten first.
+// Every KEYFRAME_INTERVAL ticks it also keeps a full EngineState (the body
+// is bit-packed; the free-cell order adds an int per free cell on normal
+// boards). A long rewind loads the nearest keyframe at or after the target
+// and undoes only the ticks between, instead of undoing every tick from the
+// present.
+
+#ifndef SNAKE_REWIND_H
+#define SNAKE_REWIND_H
+
+#include <cstddef>
+#include <vector>
+
+#include "snake_engine.h"
+
+class RewindBuffer {
+public:
+    static const int KEYFRAME_INTERVAL = 64;
+
+    // Remember up to `capacity` ticks (0 disables rewinding)
+    explicit RewindBuffer(size_t capacity = 0);
+
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return undos.size(); }
+
+    // Forget all history, e.g. when a new game starts
+    void clear();
+
+    // Step the engine and record how to take the tick back
+    StepResult step(SnakeEngine& engine, Direction requested);
+
+    // Ticks that can currently be rewound
+    size_t available() const { return count; }
+
+    // Take back up to `ticks` steps; returns how many were taken back.
+    // The engine must not have been stepped outside this buffer since the
+    // last clear().
+    size_t rewind(SnakeEngine& engine, size_t ticks);
+
+    size_t memoryBytes() const;
+
+private:
+    struct Keyframe {
+        long long tick;  // State before this tick's step; -1 if unused
+        EngineState state;
+    };
+
+    std::vector<StepUndo> undos;  // Ring indexed by tick % capacity
+    std::vector<Keyframe> keyframes;  // Ring indexed by tick / KEYFRAME_INTERVAL
+    long long ticks;  // Steps recorded since clear()
+    size_t count;     // Steps that can be undone, newest first
+
+    Keyframe* keyframeFor(long long tick);
+};
+
+#endif // SNAKE_REWIND_H
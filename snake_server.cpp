@@ -0,0 +1,1124 @@
+#include "snake_server.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "snake_engine.h"
+#include "snake_feed.h"
+#include "snake_policy.h"
+#include "snake_render.h"
+#include "snake_rewind.h"
+#include "snake_terminal.h"
+
+namespace {
+
+// Timer wheel constants
+const int WHEEL_SLOTS = 64;                 // 320 ms per lap, longer than the slowest tick
+const int WHEEL_TICK_MS = SPEED_INCREMENT;  // Every game speed is a whole number of wheel ticks
+
+// Connection constants
+const int MAX_EVENTS = 256;                 // epoll events taken per wakeup
+const size_t READ_CHUNK = 4096;
+const size_t MAX_PENDING_OUTPUT = 1 << 20;  // Unsent bytes before a stalled client is dropped
+const int MAX_SEND_SLICES = 64;             // Queue entries gathered into one sendmsg()
+
+// Spectator constants
+const size_t MAX_VIEWER_BACKLOG = 64 * 1024; // Queued bytes before a viewer skips to the keyframe
+const int SERVER_AUTOPILOT_BUDGET_MICROS = 200; // Bot planning per tick; every session shares one thread
+const size_t MAX_SUBNEGOTIATION = 64;
+
+// epoll tokens; sessions use their slot + FIRST_SESSION_TOKEN
+const uint64_t LISTENER_TOKEN = 0;
+const uint64_t SIGNAL_TOKEN = 1;
+const uint64_t FIRST_SESSION_TOKEN = 2;
+
+// Telnet protocol bytes (RFC 854, 857, 858, 1073)
+const unsigned char TELNET_SE = 240;
+const unsigned char TELNET_SB = 250;
+const unsigned char TELNET_WILL = 251;
+const unsigned char TELNET_DO = 253;
+const unsigned char TELNET_IAC = 255;
+const unsigned char TELNET_ECHO = 1;
+const unsigned char TELNET_SGA = 3;
+const unsigned char TELNET_NAWS = 31;
+
+// We echo (so the client does not), send a character at a time, and would
+// like to hear the window size
+const unsigned char TELNET_GREETING[] = {
+    TELNET_IAC, TELNET_WILL, TELNET_ECHO,
+    TELNET_IAC, TELNET_WILL, TELNET_SGA,
+    TELNET_IAC, TELNET_DO, TELNET_NAWS
+};
+
+const char ENTER_SCREEN[] = "\033[?1049h\033[?25l";  // Alternate buffer, hide cursor
+const char CLEAR_SCREEN[] = "\033[2J\033[1;1H";
+const char LEAVE_SCREEN[] = "\033[?25h\033[2J\033[1;1H\033[?1049l";
+const char SERVER_FULL[] = "Server full, try again later.\r\n";
+
+enum SessionState {
+    SESSION_WELCOME,
+    SESSION_PLAYING,
+    SESSION_GAME_OVER,
+    SESSION_WATCHING    // Spectating another session's game
+};
+
+enum TelnetState {
+    TELNET_DATA,
+    TELNET_COMMAND,             // Saw IAC
+    TELNET_OPTION,              // Saw IAC WILL/WONT/DO/DONT
+    TELNET_SUBNEGOTIATION,      // Inside IAC SB ... IAC SE
+    TELNET_SUBNEGOTIATION_IAC   // Saw IAC inside a subnegotiation
+};
+
+struct Session;
+
+// The sessions watching one game, and the feed they all share. The feed has
+// its own renderer, showing the whole board, which composes each frame once
+// for every viewer. It keeps the engine's change list for the player's
+// renderer, which always composes straight after it.
+struct Audience {
+    FrameFeed feed;
+    FrameRenderer renderer;
+    std::vector<Session*> viewers;  // Closed viewers stay until their slot is released
+    bool relayout;                  // Next keyframe must clear the screen
+
+    Audience() : relayout(true) {
+        renderer.setKeepChanges(true);
+        renderer.setHudStatus("Spectating");
+    }
+};
+
+// One connected player: a game and everything needed to show it
+struct Session : public TerminalOutput {
+    int fd;
+    int slot;
+    bool telnet;
+    SessionState state;
+    bool paused;
+    bool offerRewind;     // The game over screen offers B
+    bool frameDropped;    // A frame was skipped while output was pending
+    bool closing;         // Close once the output has drained
+    int columns;
+    int rows;
+
+    SnakeEngine engine;
+    RewindBuffer rewindBuffer;
+    FrameRenderer renderer;
+    KeyDecoder decoder;
+    TurnQueue turns;
+    Direction nextDirection;
+    std::unique_ptr<SnakePolicy> autopilot;  // Set for bot games
+
+    FrameQueue output;    // Bytes the socket has not taken yet
+    bool waitingWritable; // Registered for EPOLLOUT
+
+    Session* watching;                   // Game this session spectates
+    std::unique_ptr<Audience> audience;  // Sessions spectating this one
+
+    TelnetState telnetState;
+    std::string subnegotiation;
+
+    // Timer wheel links
+    Session* timerNext;
+    Session* timerPrev;
+    long long dueTick;
+    bool scheduled;
+
+    Session(int socket, int slotIndex, bool useTelnet)
+        : fd(socket),
+          slot(slotIndex),
+          telnet(useTelnet),
+          state(SESSION_WELCOME),
+          paused(false),
+          offerRewind(false),
+          frameDropped(false),
+          closing(false),
+          columns(FALLBACK_COLUMNS),
+          rows(FALLBACK_ROWS),
+          rewindBuffer(REWIND_HISTORY_TICKS),
+          nextDirection(NONE),
+          waitingWritable(false),
+          watching(nullptr),
+          telnetState(TELNET_DATA),
+          timerNext(nullptr),
+          timerPrev(nullptr),
+          dueTick(0),
+          scheduled(false) {
+    }
+
+    // Queue bytes for the client. A socket has no tty to turn "\n" into
+    // "\r\n", so that happens here. Frames are UTF-8 and ANSI escapes, which
+    // never contain the telnet IAC byte (0xFF), so nothing needs escaping.
+    void write(const char* data, size_t size) {
+        size_t start = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] == '\n') {
+                output.write(data + start, i - start);
+                output.write("\r\n", 2);
+                start = i + 1;
+            }
+        }
+        output.write(data + start, size - start);
+    }
+
+    using TerminalOutput::write;
+
+    size_t pendingBytes() const { return output.bytes(); }
+    bool playing() const { return fd >= 0 && !closing && state == SESSION_PLAYING; }
+};
+
+// Hashed timer wheel of session ticks. Slot i holds the sessions due on
+// wheel ticks congruent to i; ones a lap or more ahead stay put until their
+// own tick comes round. Scheduling and cancelling are O(1).
+class TimerWheel {
+public:
+    TimerWheel() : current(0), count(0) {
+        for (int i = 0; i < WHEEL_SLOTS; ++i) slots[i] = nullptr;
+    }
+
+    bool empty() const { return count == 0; }
+
+    // Last wheel tick advanced to
+    long long now() const { return current; }
+
+    // Run `s` on wheel tick `tick`, or the next one if that has passed
+    void schedule(Session* s, long long tick) {
+        cancel(s);
+        s->dueTick = std::max(tick, current + 1);
+        Session*& head = slots[s->dueTick % WHEEL_SLOTS];
+        s->timerPrev = nullptr;
+        s->timerNext = head;
+        if (head) head->timerPrev = s;
+        head = s;
+        s->scheduled = true;
+        count++;
+    }
+
+    void cancel(Session* s) {
+        if (!s->scheduled) return;
+        if (s->timerPrev) {
+            s->timerPrev->timerNext = s->timerNext;
+        } else {
+            slots[s->dueTick % WHEEL_SLOTS] = s->timerNext;
+        }
+        if (s->timerNext) s->timerNext->timerPrev = s->timerPrev;
+        s->timerNext = nullptr;
+        s->timerPrev = nullptr;
+        s->scheduled = false;
+        count--;
+    }
+
+    // First wheel tick after now() whose slot is occupied; call only when
+    // not empty(). May be early for sessions laps ahead, which is harmless.
+    long long nextOccupied() const {
+        for (int i = 1; i <= WHEEL_SLOTS; ++i) {
+            if (slots[(current + i) % WHEEL_SLOTS]) return current + i;
+        }
+        return current + WHEEL_SLOTS;
+    }
+
+    // Move to wheel tick `tick`, unscheduling every session due by then
+    // into `due`
+    void advance(long long tick, std::vector<Session*>& due) {
+        if (tick <= current) return;
+        long long visit = std::min<long long>(tick - current, WHEEL_SLOTS);
+        for (long long t = current + 1; t <= current + visit; ++t) {
+            Session* s = slots[t % WHEEL_SLOTS];
+            while (s) {
+                Session* next = s->timerNext;
+                if (s->dueTick <= tick) {
+                    cancel(s);
+                    due.push_back(s);
+                }
+                s = next;
+            }
+        }
+        current = tick;
+    }
+
+private:
+    Session* slots[WHEEL_SLOTS];
+    long long current;
+    int count;
+};
+
+} // namespace
+
+struct GameServer::Impl {
+    typedef std::chrono::steady_clock Clock;
+
+    ServerConfig config;
+    ServerReport report;
+    std::string error;
+
+    int listenFd;
+    int epollFd;
+    int signalFd;
+    bool listenTelnet;
+    std::string unixPath;       // Removed again on shutdown
+    sigset_t oldMask;
+
+    std::vector<std::unique_ptr<Session> > sessions;  // Indexed by slot
+    std::vector<int> freeSlots;
+    std::vector<int> releasedSlots;  // Closed this batch; reusable after it
+    int active;
+
+    SharedFrame clearFrame;     // Queued ahead of a viewer's catch-up chain
+
+    TimerWheel wheel;
+    Clock::time_point epoch;    // Wheel tick 0
+    std::vector<Session*> due;  // Scratch for the timer wheel
+    bool stopping;
+
+    Impl()
+        : report(),
+          listenFd(-1),
+          epollFd(-1),
+          signalFd(-1),
+          listenTelnet(false),
+          active(0),
+          clearFrame(std::make_shared<const std::string>(CLEAR_SCREEN)),
+          stopping(false) {
+    }
+
+    ~Impl() {
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            if (sessions[i] && sessions[i]->fd >= 0) close(sessions[i]->fd);
+        }
+        if (signalFd >= 0) close(signalFd);
+        if (epollFd >= 0) close(epollFd);
+        if (listenFd >= 0) close(listenFd);
+        if (!unixPath.empty()) unlink(unixPath.c_str());
+    }
+
+    bool fail(const std::string& what) {
+        error = what + ": " + strerror(errno);
+        return false;
+    }
+
+    bool watch(int fd, uint32_t events, uint64_t token, int op) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = token;
+        return epoll_ctl(epollFd, op, fd, &ev) == 0;
+    }
+
+    // --- Listening ---
+
+    bool listenUnix(const std::string& path) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            error = "bad socket path: " + path;
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) return fail("socket");
+        if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            // A socket file left by a server that is gone refuses
+            // connections; take it over, but never one that is still live
+            struct stat st;
+            if (errno != EADDRINUSE || stat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+                return fail("bind " + path);
+            }
+            int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            bool live = probe >= 0 &&
+                connect(probe, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+            if (probe >= 0) close(probe);
+            errno = EADDRINUSE;
+            if (live || unlink(path.c_str()) != 0 ||
+                bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+                return fail("bind " + path);
+            }
+        }
+        unixPath = path;
+        listenTelnet = false;
+        return true;
+    }
+
+    bool listenTcp(const std::string& host, const std::string& port) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        struct addrinfo* found = nullptr;
+        int status = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found);
+        if (status != 0) {
+            error = "cannot resolve " + host + ":" + port + ": " + gai_strerror(status);
+            return false;
+        }
+        for (struct addrinfo* ai = found; ai; ai = ai->ai_next) {
+            int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) continue;
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                listenFd = fd;
+                break;
+            }
+            int saved = errno;
+            close(fd);
+            errno = saved;
+        }
+        freeaddrinfo(found);
+        if (listenFd < 0) return fail("bind " + host + ":" + port);
+        listenTelnet = true;
+        return true;
+    }
+
+    bool open() {
+        const std::string& address = config.address;
+        bool bound;
+        if (address.compare(0, 5, "unix:") == 0) {
+            bound = listenUnix(address.substr(5));
+        } else {
+            // "PORT" listens on loopback only; "HOST:PORT" or ":PORT" to share
+            std::string host = "127.0.0.1";
+            std::string port = address;
+            size_t colon = address.rfind(':');
+            if (colon != std::string::npos) {
+                host = address.substr(0, colon);
+                port = address.substr(colon + 1);
+                if (host.size() >= 2 && host[0] == '[' && host[host.size() - 1] == ']') {
+                    host = host.substr(1, host.size() - 2);  // [IPv6]:PORT
+                }
+            }
+            bound = listenTcp(host, port);
+        }
+        if (!bound) return false;
+        if (listen(listenFd, SOMAXCONN) != 0) return fail("listen");
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) return fail("epoll_create1");
+        if (!watch(listenFd, EPOLLIN, LISTENER_TOKEN, EPOLL_CTL_ADD)) return fail("epoll_ctl");
+        return true;
+    }
+
+    // --- Output ---
+
+    // Send as much pending output as the socket takes, shared frames and
+    // all, with one sendmsg() per batch of queue entries. Waits for EPOLLOUT
+    // when it backs up, and drops clients that stop reading altogether.
+    void flush(Session* s) {
+        struct iovec slices[MAX_SEND_SLICES];
+        while (s->fd >= 0 && !s->output.empty()) {
+            struct msghdr message;
+            memset(&message, 0, sizeof(message));
+            message.msg_iov = slices;
+            message.msg_iovlen = s->output.gather(slices, MAX_SEND_SLICES);
+            ssize_t n = sendmsg(s->fd, &message, MSG_NOSIGNAL);
+            if (n > 0) {
+                s->output.consume(static_cast<size_t>(n));
+                report.bytesSent += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                drop(s);
+                return;
+            }
+        }
+        if (s->fd < 0) return;
+
+        if (s->pendingBytes() == 0) {
+            if (s->closing) {
+                drop(s);
+                return;
+            }
+            if (s->waitingWritable) {
+                s->waitingWritable = false;
+                watch(s->fd, EPOLLIN | EPOLLRDHUP, FIRST_SESSION_TOKEN + s->slot, EPOLL_CTL_MOD);
+            }
+            return;
+        }
+
+        if (s->pendingBytes() > MAX_PENDING_OUTPUT) {
+            drop(s);
+            return;
+        }
+        if (!s->waitingWritable) {
+            s->waitingWritable = true;
+            watch(s->fd, EPOLLIN | EPOLLRDHUP | EPOLLOUT, FIRST_SESSION_TOKEN + s->slot, EPOLL_CTL_MOD);
+        }
+    }
+
+    // Compose and queue the next frame, unless the client is still taking
+    // earlier output; then the frame is skipped and redrawn once it drains.
+    // Spectators get theirs first, whether or not the player's is skipped.
+    void render(Session* s) {
+        broadcast(s);
+        flush(s);
+        if (s->fd < 0) return;
+        if (s->pendingBytes() > 0) {
+            s->frameDropped = true;
+            report.droppedFrames++;
+            return;
+        }
+        s->frameDropped = false;
+        if (s->renderer.compose(s->engine, s->paused)) {
+            s->write(s->renderer.frame());
+        }
+        flush(s);
+    }
+
+    // --- Spectators ---
+
+    // Compose the game once for everyone watching it and queue that one
+    // buffer for each of them. Must run before the player's own compose,
+    // which clears the engine's change list.
+    void broadcast(Session* s) {
+        Audience* a = s->audience.get();
+        if (!a || a->viewers.empty()) return;
+        if (a->relayout || a->feed.wantsKeyframe()) a->renderer.invalidate();
+        if (!a->renderer.compose(s->engine, s->paused)) return;
+
+        bool keyframe = a->renderer.fullFrame();
+        SharedFrame frame = a->feed.publish(a->renderer.frame(), keyframe, keyframe && a->relayout);
+        if (keyframe) a->relayout = false;
+        for (size_t i = 0; i < a->viewers.size(); ++i) {
+            Session* v = a->viewers[i];
+            if (v->fd < 0) continue;
+            if (v->pendingBytes() + frame->size() > MAX_VIEWER_BACKLOG) {
+                // Too far behind to catch up frame by frame
+                v->output.discardUnsent();
+                catchUp(v, a->feed);
+                report.viewerSkips++;
+            } else {
+                v->output.push(frame);
+            }
+            flush(v);
+        }
+    }
+
+    // Queue a screen clear and the feed's latest keyframe with every frame
+    // since, which leaves the viewer showing the live frame
+    void catchUp(Session* v, const FrameFeed& feed) {
+        const std::vector<SharedFrame>& chain = feed.chain();
+        if (chain.empty()) return;  // The next broadcast brings a keyframe
+        v->output.push(clearFrame);
+        for (size_t i = 0; i < chain.size(); ++i) {
+            v->output.push(chain[i]);
+        }
+    }
+
+    // First game being played at or after slot `from`, wrapping round,
+    // other than `viewer`'s own
+    Session* findGame(int from, const Session* viewer) const {
+        size_t count = sessions.size();
+        for (size_t i = 0; i < count; ++i) {
+            Session* s = sessions[(from + i) % count].get();
+            if (s && s != viewer && s->playing()) return s;
+        }
+        return nullptr;
+    }
+
+    void startWatching(Session* v, Session* target) {
+        stopWatching(v);
+        if (!target->audience) target->audience.reset(new Audience());
+        Audience& a = *target->audience;
+        if (a.viewers.empty()) {
+            // Nobody has been composing this feed; start it afresh
+            a.feed.reset();
+            a.relayout = true;
+        }
+        a.viewers.push_back(v);
+        v->watching = target;
+        v->state = SESSION_WATCHING;
+        v->output.discardUnsent();
+        report.spectators++;
+        if (a.feed.chain().empty()) {
+            broadcast(target);
+        } else {
+            catchUp(v, a.feed);
+            flush(v);
+        }
+        countViewers(target);
+    }
+
+    void stopWatching(Session* v) {
+        Session* target = v->watching;
+        if (!target) return;
+        std::vector<Session*>& viewers = target->audience->viewers;
+        viewers.erase(std::remove(viewers.begin(), viewers.end(), v), viewers.end());
+        v->watching = nullptr;
+        countViewers(target);
+    }
+
+    // Watch the next game after slot `from`, or go back to the welcome screen
+    void watchNext(Session* v, int from) {
+        Session* next = findGame(from, v);
+        if (next) {
+            if (next != v->watching) startWatching(v, next);
+            return;
+        }
+        stopWatching(v);
+        v->output.discardUnsent();
+        v->state = SESSION_WELCOME;
+        drawWelcome(v);
+        std::string note = std::string("\n\n  ") + YELLOW + "No games are being played right now." + RESET;
+        v->write(note);
+        flush(v);
+    }
+
+    // Show the player how many are watching
+    void countViewers(Session* s) {
+        int watching = 0;
+        if (s->audience) {
+            for (size_t i = 0; i < s->audience->viewers.size(); ++i) {
+                if (s->audience->viewers[i]->fd >= 0) watching++;
+            }
+        }
+        char status[32] = "";
+        if (watching > 0) snprintf(status, sizeof(status), "%d watching", watching);
+        s->renderer.setHudStatus(status);
+        if (s->playing()) render(s);
+    }
+
+    void drawWelcome(Session* s) {
+        std::string screen = CLEAR_SCREEN;
+        appendWelcomeScreen(screen);
+        screen += std::string("\n\n  Or press ") + MAGENTA + "A" + RESET + " to let the autopilot play, " +
+                  MAGENTA + "V" + RESET + " to watch a game in progress";
+        s->write(screen);
+    }
+
+    void drawGameOver(Session* s) {
+        std::string screen = CLEAR_SCREEN;
+        appendGameOverScreen(screen, s->engine.score(), s->engine.body().size(), s->offerRewind);
+        s->write(screen);
+    }
+
+    // --- Game flow ---
+
+    int tickInterval(const Session* s) const {
+        return std::max(1, s->engine.speed() / WHEEL_TICK_MS);
+    }
+
+    // Start a game, played by the autopilot if `bot`
+    void startGame(Session* s, bool bot) {
+        BoardFit fit = fitBoard(s->columns, s->rows);
+        uint64_t seed = config.fixedSeed ? config.seed
+            : static_cast<uint64_t>(Clock::now().time_since_epoch().count()) + s->slot;
+
+        s->renderer.setViewport(fit.viewWidth, fit.viewHeight);
+        s->engine.reset(fit.width, fit.height, seed);
+        if (bot) {
+            s->autopilot = createPolicy(POLICY_AUTOPILOT, seed, SERVER_AUTOPILOT_BUDGET_MICROS);
+            s->autopilot->newGame(s->engine);
+        } else {
+            s->autopilot.reset();
+        }
+        if (s->audience) s->audience->relayout = true;
+        s->rewindBuffer.clear();
+        s->engine.setChangeTracking(s->renderer.deltaRendering());
+        s->renderer.setWarning(fit.warning);
+        s->renderer.invalidate();
+        s->nextDirection = NONE;
+        s->turns.clear();
+        s->paused = false;
+        s->state = SESSION_PLAYING;
+        report.games++;
+
+        s->write(CLEAR_SCREEN);
+        render(s);
+        wheel.schedule(s, wheel.now() + tickInterval(s));
+    }
+
+    void endGame(Session* s) {
+        wheel.cancel(s);
+        broadcast(s);  // Spectators keep the final board on screen
+        s->state = SESSION_GAME_OVER;
+        s->offerRewind = s->rewindBuffer.available() > 0;
+        drawGameOver(s);
+        flush(s);
+    }
+
+    // Take back about REWIND_STEP_MS of play and pause
+    void rewind(Session* s) {
+        if (s->rewindBuffer.available() == 0) return;
+        s->rewindBuffer.rewind(s->engine, std::max(1, REWIND_STEP_MS / s->engine.speed()));
+        wheel.cancel(s);
+        if (s->autopilot) s->autopilot->newGame(s->engine);
+        s->renderer.invalidate();
+        if (s->audience) s->audience->renderer.invalidate();
+        s->nextDirection = NONE;
+        s->turns.clear();
+        s->paused = true;
+        s->state = SESSION_PLAYING;
+        render(s);
+    }
+
+    void quit(Session* s) {
+        wheel.cancel(s);
+        s->write(LEAVE_SCREEN);
+        s->write(std::string("\n\n  ") + CYAN + "Thanks for playing! 🐍\n\n" + RESET);
+        s->closing = true;
+        flush(s);
+    }
+
+    // One simulation step, from the timer wheel
+    void tick(Session* s) {
+        s->turns.pop(s->nextDirection);
+        if (s->autopilot) s->nextDirection = s->autopilot->choose(s->engine);
+        report.ticks++;
+        if (s->rewindBuffer.step(s->engine, s->nextDirection) == STEP_GAME_OVER) {
+            endGame(s);
+            return;
+        }
+        render(s);
+
+        // Fixed rate: the next tick is due one period after this one was,
+        // unless the server fell behind, then one period from now
+        long long next = s->dueTick + tickInterval(s);
+        if (next <= wheel.now()) next = wheel.now() + tickInterval(s);
+        if (s->fd >= 0) wheel.schedule(s, next);
+    }
+
+    void playKey(Session* s, char key) {
+        switch (key) {
+            case 'w':
+            case 'W':
+                s->turns.push(UP, s->engine.direction());
+                break;
+            case 's':
+            case 'S':
+                s->turns.push(DOWN, s->engine.direction());
+                break;
+            case 'a':
+            case 'A':
+                s->turns.push(LEFT, s->engine.direction());
+                break;
+            case 'd':
+            case 'D':
+                s->turns.push(RIGHT, s->engine.direction());
+                break;
+            case ' ':
+                // A paused game leaves the wheel, so it costs nothing
+                s->paused = !s->paused;
+                if (s->paused) {
+                    wheel.cancel(s);
+                } else {
+                    wheel.schedule(s, wheel.now() + tickInterval(s));
+                }
+                render(s);
+                break;
+            case 'b':
+            case 'B':
+                rewind(s);
+                break;
+            case 'q':
+            case 'Q':
+                endGame(s);
+                break;
+        }
+    }
+
+    void handleKey(Session* s, char key) {
+        switch (s->state) {
+            case SESSION_WELCOME:
+                if (key == '\n' || key == '\r') {
+                    startGame(s, false);
+                } else if (key == 'a' || key == 'A') {
+                    startGame(s, true);
+                } else if (key == 'v' || key == 'V') {
+                    watchNext(s, 0);
+                } else if (key == 'q' || key == 'Q') {
+                    quit(s);
+                }
+                break;
+            case SESSION_PLAYING:
+                playKey(s, key);
+                break;
+            case SESSION_GAME_OVER:
+                if (key == 'r' || key == 'R') {
+                    startGame(s, s->autopilot != nullptr);
+                } else if (s->offerRewind && (key == 'b' || key == 'B')) {
+                    s->write(CLEAR_SCREEN);
+                    rewind(s);
+                } else if (key == 'q' || key == 'Q') {
+                    quit(s);
+                }
+                break;
+            case SESSION_WATCHING:
+                if (key == 'n' || key == 'N') {
+                    watchNext(s, s->watching->slot + 1);
+                } else if (key == 'q' || key == 'Q') {
+                    stopWatching(s);
+                    s->output.discardUnsent();
+                    s->state = SESSION_WELCOME;
+                    drawWelcome(s);
+                }
+                break;
+        }
+    }
+
+    // The client's window changed size; redraw whatever is showing to fit.
+    // A running game keeps its board and only changes how much is shown.
+    void resize(Session* s, int columns, int rows) {
+        if (columns <= 0 || rows <= 0) return;
+        if (columns == s->columns && rows == s->rows) return;
+        s->columns = columns;
+        s->rows = rows;
+        switch (s->state) {
+            case SESSION_WELCOME:
+                drawWelcome(s);
+                break;
+            case SESSION_PLAYING: {
+                BoardFit fit = fitBoard(columns, rows);
+                s->renderer.setViewport(fit.viewWidth, fit.viewHeight);
+                s->renderer.invalidate();
+                s->write(CLEAR_SCREEN);
+                render(s);
+                break;
+            }
+            case SESSION_GAME_OVER:
+                drawGameOver(s);
+                break;
+            case SESSION_WATCHING:
+                // The feed's layout is fixed; just repaint it
+                s->output.discardUnsent();
+                catchUp(s, s->watching->audience->feed);
+                break;
+        }
+    }
+
+    // --- Input ---
+
+    // Strip telnet commands from the input; true with `data` set for an
+    // ordinary byte. Option replies need no answer, since we only ever make
+    // the offers in TELNET_GREETING; window size reports are applied.
+    bool telnetByte(Session* s, unsigned char c, char& data) {
+        switch (s->telnetState) {
+            case TELNET_DATA:
+                if (c == TELNET_IAC) {
+                    s->telnetState = TELNET_COMMAND;
+                    return false;
+                }
+                data = static_cast<char>(c);
+                return true;
+
+            case TELNET_COMMAND:
+                if (c == TELNET_IAC) {  // Escaped 0xFF
+                    s->telnetState = TELNET_DATA;
+                    data = static_cast<char>(c);
+                    return true;
+                }
+                if (c >= TELNET_WILL) {
+                    s->telnetState = TELNET_OPTION;
+                } else if (c == TELNET_SB) {
+                    s->subnegotiation.clear();
+                    s->telnetState = TELNET_SUBNEGOTIATION;
+                } else {
+                    s->telnetState = TELNET_DATA;  // NOP, GA and friends
+                }
+                return false;
+
+            case TELNET_OPTION:
+                s->telnetState = TELNET_DATA;
+                return false;
+
+            case TELNET_SUBNEGOTIATION:
+                if (c == TELNET_IAC) {
+                    s->telnetState = TELNET_SUBNEGOTIATION_IAC;
+                } else if (s->subnegotiation.size() < MAX_SUBNEGOTIATION) {
+                    s->subnegotiation += static_cast<char>(c);
+                }
+                return false;
+
+            case TELNET_SUBNEGOTIATION_IAC:
+                if (c == TELNET_IAC) {
+                    if (s->subnegotiation.size() < MAX_SUBNEGOTIATION) {
+                        s->subnegotiation += static_cast<char>(c);
+                    }
+                    s->telnetState = TELNET_SUBNEGOTIATION;
+                    return false;
+                }
+                s->telnetState = TELNET_DATA;
+                if (c == TELNET_SE) windowSize(s);
+                return false;
+        }
+        return false;
+    }
+
+    // IAC SB NAWS width(16) height(16) IAC SE
+    void windowSize(Session* s) {
+        const std::string& sub = s->subnegotiation;
+        if (sub.size() < 5 || static_cast<unsigned char>(sub[0]) != TELNET_NAWS) return;
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(sub.data());
+        resize(s, (p[1] << 8) | p[2], (p[3] << 8) | p[4]);
+    }
+
+    void readable(Session* s) {
+        char buffer[READ_CHUNK];
+        while (s->fd >= 0 && !s->closing) {
+            ssize_t n = read(s->fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) {
+                drop(s);
+                return;
+            }
+            for (ssize_t i = 0; i < n && s->fd >= 0 && !s->closing; ++i) {
+                char c = buffer[i];
+                if (s->telnet && !telnetByte(s, static_cast<unsigned char>(c), c)) continue;
+                char key;
+                if (s->decoder.feed(c, key)) handleKey(s, key);
+            }
+        }
+        flush(s);
+    }
+
+    void writable(Session* s) {
+        flush(s);
+        if (s->fd >= 0 && s->pendingBytes() == 0 && s->frameDropped &&
+            s->state == SESSION_PLAYING) {
+            render(s);
+        }
+    }
+
+    // --- Sessions ---
+
+    void accept() {
+        for (;;) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;  // EAGAIN, or out of descriptors until someone leaves
+            }
+            if (active >= config.maxSessions) {
+                send(fd, SERVER_FULL, sizeof(SERVER_FULL) - 1, MSG_NOSIGNAL);
+                close(fd);
+                continue;
+            }
+            if (listenTelnet) {
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+
+            int slot;
+            if (freeSlots.empty()) {
+                slot = static_cast<int>(sessions.size());
+                sessions.push_back(std::unique_ptr<Session>());
+            } else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            if (!watch(fd, EPOLLIN | EPOLLRDHUP, FIRST_SESSION_TOKEN + slot, EPOLL_CTL_ADD)) {
+                close(fd);
+                freeSlots.push_back(slot);
+                continue;
+            }
+            Session* s = new Session(fd, slot, listenTelnet);
+            sessions[slot].reset(s);
+            active++;
+            report.sessions++;
+            report.peakSessions = std::max(report.peakSessions, active);
+
+            if (s->telnet) {
+                s->write(reinterpret_cast<const char*>(TELNET_GREETING), sizeof(TELNET_GREETING));
+            }
+            s->write(ENTER_SCREEN);
+            drawWelcome(s);
+            flush(s);
+        }
+    }
+
+    // Close a session now. Its slot is reused only after the current event
+    // batch, so later events in the batch for the old socket are ignored.
+    // Anyone watching moves on to another game. A closed viewer stays in
+    // its game's audience until then too, since broadcasts may be under way.
+    void drop(Session* s) {
+        if (s->fd < 0) return;
+        wheel.cancel(s);
+        close(s->fd);
+        s->fd = -1;
+        active--;
+        releasedSlots.push_back(s->slot);
+
+        if (s->audience) {
+            std::vector<Session*> orphans;
+            orphans.swap(s->audience->viewers);
+            for (size_t i = 0; i < orphans.size(); ++i) {
+                orphans[i]->watching = nullptr;
+            }
+            for (size_t i = 0; i < orphans.size(); ++i) {
+                if (orphans[i]->fd >= 0) watchNext(orphans[i], s->slot + 1);
+            }
+        }
+    }
+
+    void releaseSlots() {
+        // Leaving an audience can redraw, and so drop, another session
+        for (size_t i = 0; i < releasedSlots.size(); ++i) {
+            stopWatching(sessions[releasedSlots[i]].get());
+        }
+        for (size_t i = 0; i < releasedSlots.size(); ++i) {
+            sessions[releasedSlots[i]].reset();
+            freeSlots.push_back(releasedSlots[i]);
+        }
+        releasedSlots.clear();
+    }
+
+    // --- Event loop ---
+
+    long long wheelTickAt(Clock::time_point t) const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(t - epoch).count() / WHEEL_TICK_MS;
+    }
+
+    // epoll_wait timeout: until the next occupied wheel slot, or forever
+    int waitMillis() const {
+        if (wheel.empty()) return -1;
+        Clock::time_point deadline = epoch + std::chrono::milliseconds(wheel.nextOccupied() * WHEEL_TICK_MS);
+        long long micros = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count();
+        // Round up so we never wake just before the slot and spin
+        return micros <= 0 ? 0 : static_cast<int>((micros + 999) / 1000);
+    }
+
+    void runDueTicks() {
+        wheel.advance(wheelTickAt(Clock::now()), due);
+        for (size_t i = 0; i < due.size(); ++i) {
+            Session* s = due[i];
+            if (s->fd >= 0 && s->state == SESSION_PLAYING && !s->paused) tick(s);
+        }
+        due.clear();
+    }
+
+    bool run() {
+        sigset_t stopSignals;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        if (sigprocmask(SIG_BLOCK, &stopSignals, &oldMask) != 0) return fail("sigprocmask");
+        signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signalFd < 0 || !watch(signalFd, EPOLLIN, SIGNAL_TOKEN, EPOLL_CTL_ADD)) {
+            fail("signalfd");
+            sigprocmask(SIG_SETMASK, &oldMask, nullptr);
+            return false;
+        }
+
+        epoch = Clock::now();
+        bool ok = true;
+        struct epoll_event events[MAX_EVENTS];
+        while (!stopping) {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, waitMillis());
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                ok = fail("epoll_wait");
+                break;
+            }
+            runDueTicks();
+
+            for (int i = 0; i < ready; ++i) {
+                uint64_t token = events[i].data.u64;
+                uint32_t flags = events[i].events;
+                if (token == LISTENER_TOKEN) {
+                    accept();
+                    continue;
+                }
+                if (token == SIGNAL_TOKEN) {
+                    // Consume it, or it is delivered when the mask is restored
+                    struct signalfd_siginfo info;
+                    while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                        stopping = true;
+                    }
+                    continue;
+                }
+                Session* s = sessions[token - FIRST_SESSION_TOKEN].get();
+                if (!s || s->fd < 0) continue;  // Closed earlier in this batch
+                if (flags & (EPOLLERR | EPOLLHUP)) {
+                    drop(s);
+                    continue;
+                }
+                if (flags & EPOLLOUT) writable(s);
+                if (flags & (EPOLLIN | EPOLLRDHUP)) readable(s);
+            }
+            releaseSlots();
+        }
+
+        // Put every client's terminal back before hanging up
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            Session* s = sessions[i].get();
+            if (!s || s->fd < 0) continue;
+            s->output.discardUnsent();
+            s->write(LEAVE_SCREEN);
+            s->write("Server shutting down.\n");
+            struct iovec slices[MAX_SEND_SLICES];
+            struct msghdr message;
+            memset(&message, 0, sizeof(message));
+            message.msg_iov = slices;
+            message.msg_iovlen = s->output.gather(slices, MAX_SEND_SLICES);
+            sendmsg(s->fd, &message, MSG_NOSIGNAL);  // Best effort
+            drop(s);
+        }
+        releaseSlots();
+        sigprocmask(SIG_SETMASK, &oldMask, nullptr);
+        return ok;
+    }
+};
+
+bool GameServer::open() {
+    return impl->open();
+}
+
+bool GameServer::run() {
+    return impl->run();
+}
+
+#else
+
+struct GameServer::Impl {
+    ServerConfig config;
+    ServerReport report;
+    std::string error;
+
+    Impl() : report() {}
+};
+
+bool GameServer::open() {
+    impl->error = "the game server needs Linux (epoll)";
+    return false;
+}
+
+bool GameServer::run() {
+    return false;
+}
+
+#endif
+
+GameServer::GameServer(const ServerConfig& config) : impl(new Impl()) {
+    impl->config = config;
+}
+
+GameServer::~GameServer() {
+}
+
+const std::string& GameServer::error() const {
+    return impl->error;
+}
+
+const ServerReport& GameServer::report() const {
+    return impl->report;
+}
@@ -0,0 +1,74 @@
+// Multi-session game server.
+//
+// GameServer plays any number of independent games at once, one per
+// connection, from a single thread. Everything is driven by one epoll loop:
+//
+//   sockets  The listener, each session's socket and a signalfd for SIGINT
+//            and SIGTERM. Sessions read keys and write frames without ever
+//            blocking; output that the client cannot take yet waits in the
+//            session's own buffer, and frames are dropped until it drains.
+//   timers   A hashed timer wheel with SPEED_INCREMENT granularity holds the
+//            next tick of every running game, each at its own speed. epoll
+//            sleeps until the next occupied wheel slot, or indefinitely when
+//            every game is paused or on a menu, so idle sessions cost nothing.
+//
+// Sessions reach their player through TerminalOutput and decode keys with
+// KeyDecoder, and share board sizing and screens with the local game via
+// snake_terminal.h. TCP connections speak enough telnet for `telnet HOST
+// PORT` to work, including window size (NAWS); Unix socket connections are
+// a raw byte stream. Linux only.
+
+#ifndef SNAKE_SERVER_H
+#define SNAKE_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct ServerConfig {
+    std::string address;  // "PORT", "HOST:PORT" or "unix:PATH"
+    int maxSessions;      // Further connections are turned away
+    bool fixedSeed;       // Use `seed` for every game instead of the clock
+    uint64_t seed;
+
+    ServerConfig()
+        : maxSessions(4096),
+          fixedSeed(false),
+          seed(0) {
+    }
+};
+
+struct ServerReport {
+    long long sessions;       // Connections accepted
+    int peakSessions;         // Most connected at once
+    long long games;
+    long long ticks;          // Simulation steps across all sessions
+    long long droppedFrames;  // Frames skipped while a client fell behind
+    long long bytesSent;
+    long long spectators;     // Times a session started watching a game
+    long long viewerSkips;    // Viewers skipped ahead to the latest keyframe
+};
+
+class GameServer {
+public:
+    explicit GameServer(const ServerConfig& config);
+    ~GameServer();
+
+    // Start listening; false with error() set on failure
+    bool open();
+    const std::string& error() const;
+
+    // Serve until SIGINT or SIGTERM, then say goodbye to every session
+    bool run();
+
+    const ServerReport& report() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+
+    GameServer(const GameServer&);
+    GameServer& operator=(const GameServer&);
+};
+
+#endif // SNAKE_SERVER_H
@@ -0,0 +1,187 @@
+#include "snake_stats.h"
+
+#include <algorithm>
+
+namespace {
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {"input", "tick", "compose", "write", "frame"};
+
+// Position of the highest set bit; `value` must be non-zero
+int highestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+double nanosToMicros(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+} // namespace
+
+const char* framePhaseName(FramePhase phase) {
+    return phase >= 0 && phase < PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void LatencyHistogram::clear() {
+    std::fill(buckets, buckets + BUCKET_COUNT, 0ULL);
+    samples = 0;
+    largest = 0;
+    sum = 0.0;
+}
+
+// Values below 8 get a bucket each; above that, each power of two is split
+// into 8 equal buckets
+int LatencyHistogram::bucketFor(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+    int bit = highestBit(value);
+    int sub = static_cast<int>((value >> (bit - 3)) & (SUB_BUCKETS - 1));
+    return (bit - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int bit = bucket / SUB_BUCKETS + 2;
+    uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+    uint64_t width = 1ULL << (bit - 3);
+    return ((SUB_BUCKETS + sub) << (bit - 3)) + width - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketFor(value)]++;
+    samples++;
+    largest = std::max(largest, value);
+    sum += static_cast<double>(value);
+}
+
+double LatencyHistogram::mean() const {
+    return samples > 0 ? sum / static_cast<double>(samples) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (samples == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(samples - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), largest);
+        }
+    }
+    return largest;
+}
+
+FrameStats::FrameStats()
+    : totalBytes(0),
+      droppedFrames(0),
+      scheduledTicks(0),
+      lateTicks(0),
+      resyncs(0),
+      worstLagMs(0.0),
+      windowBytes(0),
+      windowWrites(0) {
+}
+
+void FrameStats::record(FramePhase phase, Clock::duration elapsed) {
+    long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    uint64_t value = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+    phases[phase].record(value);
+    if (phase == PHASE_FRAME) {
+        windowFrames.record(value);
+    }
+}
+
+void FrameStats::recordFrameBytes(size_t frameBytes) {
+    bytes.record(frameBytes);
+    totalBytes += frameBytes;
+    windowBytes += frameBytes;
+    windowWrites++;
+}
+
+void FrameStats::setSchedule(long long ticks, long long late, long long resyncCount, double worstLag) {
+    scheduledTicks = ticks;
+    lateTicks = late;
+    resyncs = resyncCount;
+    worstLagMs = worstLag;
+}
+
+std::string FrameStats::takeHudSummary() {
+    char line[96];
+    snprintf(line, sizeof(line), "frame p50 %.2fms p99 %.2fms  %llu B/frame",
+             windowFrames.percentile(0.50) / 1e6,
+             windowFrames.percentile(0.99) / 1e6,
+             static_cast<unsigned long long>(windowWrites > 0 ? windowBytes / windowWrites : 0));
+    windowFrames.clear();
+    windowBytes = 0;
+    windowWrites = 0;
+    return line;
+}
+
+bool FrameStats::write(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    bool ok = csv ? writeCsv(file) : writeJson(file);
+    return fclose(file) == 0 && ok;
+}
+
+bool FrameStats::writeJson(FILE* file) const {
+    fprintf(file, "{\n  \"phases_us\": {\n");
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        const LatencyHistogram& h = phases[i];
+        fprintf(file, "    \"%s\": {\"count\": %llu, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                      "\"p99\": %.3f, \"max\": %.3f}%s\n",
+                PHASE_NAMES[i], static_cast<unsigned long long>(h.count()), h.mean() / 1000.0,
+                nanosToMicros(h.percentile(0.50)), nanosToMicros(h.percentile(0.90)),
+                nanosToMicros(h.percentile(0.99)), nanosToMicros(h.max()),
+                i + 1 < PHASE_COUNT ? "," : "");
+    }
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"frame_bytes\": {\"frames\": %llu, \"total\": %llu, \"mean\": %.1f, \"p50\": %llu, "
+                  "\"p99\": %llu, \"max\": %llu},\n",
+            static_cast<unsigned long long>(bytes.count()), static_cast<unsigned long long>(totalBytes),
+            bytes.mean(), static_cast<unsigned long long>(bytes.percentile(0.50)),
+            static_cast<unsigned long long>(bytes.percentile(0.99)),
+            static_cast<unsigned long long>(bytes.max()));
+    fprintf(file, "  \"schedule\": {\"ticks\": %lld, \"late_ticks\": %lld, \"resyncs\": %lld, "
+                  "\"worst_lag_ms\": %.3f, \"dropped_frames\": %llu}\n}\n",
+            scheduledTicks, lateTicks, resyncs, worstLagMs,
+            static_cast<unsigned long long>(droppedFrames));
+    return !ferror(file);
+}
+
+bool FrameStats::writeCsv(FILE* file) const {
+    fprintf(file, "metric,unit,count,mean,p50,p90,p99,max\n");
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        const LatencyHistogram& h = phases[i];
+        fprintf(file, "%s,us,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                PHASE_NAMES[i], static_cast<unsigned long long>(h.count()), h.mean() / 1000.0,
+                nanosToMicros(h.percentile(0.50)), nanosToMicros(h.percentile(0.90)),
+                nanosToMicros(h.percentile(0.99)), nanosToMicros(h.max()));
+    }
+    fprintf(file, "frame_bytes,bytes,%llu,%.1f,%llu,%llu,%llu,%llu\n",
+            static_cast<unsigned long long>(bytes.count()), bytes.mean(),
+            static_cast<unsigned long long>(bytes.percentile(0.50)),
+            static_cast<unsigned long long>(bytes.percentile(0.90)),
+            static_cast<unsigned long long>(bytes.percentile(0.99)),
+            static_cast<unsigned long long>(bytes.max()));
+    fprintf(file, "total_bytes,bytes,%llu,,,,,\n", static_cast<unsigned long long>(totalBytes));
+    fprintf(file, "ticks,ticks,%lld,,,,,\n", scheduledTicks);
+    fprintf(file, "late_ticks,ticks,%lld,,,,,\n", lateTicks);
+    fprintf(file, "resyncs,count,%lld,,,,,\n", resyncs);
+    fprintf(file, "worst_lag,ms,1,%.3f,,,,%.3f\n", worstLagMs, worstLagMs);
+    fprintf(file, "dropped_frames,frames,%llu,,,,,\n", static_cast<unsigned long long>(droppedFrames));
+    return !ferror(file);
+}
@@ -0,0 +1,98 @@
+// Frame timing and output statistics for the terminal frontend.
+//
+// LatencyHistogram keeps log-linear buckets (8 per power of two), so a
+// sample costs a few integer operations, memory stays fixed however long a
+// session runs, and percentiles are accurate to within 12.5%. FrameStats
+// keeps one histogram per frame phase plus output byte counts, and writes
+// everything as JSON or CSV for offline tracking.
+
+#ifndef SNAKE_STATS_H
+#define SNAKE_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Parts of a frame that are timed separately
+enum FramePhase {
+    PHASE_INPUT,    // Draining and handling keys
+    PHASE_TICK,     // Choosing a direction and stepping the engine
+    PHASE_COMPOSE,  // Building the frame's bytes
+    PHASE_WRITE,    // Writing the bytes to the terminal, on the writer thread
+    PHASE_FRAME,    // Tick and compose, up to handing the frame to the writer
+    PHASE_COUNT
+};
+
+const char* framePhaseName(FramePhase phase);
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    void clear();
+
+    uint64_t count() const { return samples; }
+    uint64_t max() const { return largest; }
+    double mean() const;
+    // Upper bound of the bucket holding the `fraction` quantile (0..1)
+    uint64_t percentile(double fraction) const;
+
+private:
+    static const int SUB_BUCKETS = 8;
+    static const int BUCKET_COUNT = (64 - 2) * SUB_BUCKETS;
+
+    uint64_t buckets[BUCKET_COUNT];
+    uint64_t samples;
+    uint64_t largest;
+    double sum;
+
+    static int bucketFor(uint64_t value);
+    static uint64_t bucketUpperBound(int bucket);
+};
+
+class FrameStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameStats();
+
+    // Phase durations are kept in nanoseconds
+    void record(FramePhase phase, Clock::duration elapsed);
+    void recordFrameBytes(size_t bytes);
+    // A frame skipped because the terminal was still busy with the last one
+    void recordDroppedFrame() { droppedFrames++; }
+
+    // Tick schedule figures, reported with the histograms
+    void setSchedule(long long ticks, long long lateTicks, long long resyncs, double worstLagMs);
+
+    const LatencyHistogram& phase(FramePhase p) const { return phases[p]; }
+    const LatencyHistogram& frameBytes() const { return bytes; }
+
+    // One-line summary of frames since the previous call, for the HUD
+    std::string takeHudSummary();
+
+    // Write everything to `path`; CSV if it ends in ".csv", JSON otherwise
+    bool write(const std::string& path) const;
+
+private:
+    LatencyHistogram phases[PHASE_COUNT];
+    LatencyHistogram bytes;
+    uint64_t totalBytes;
+    uint64_t droppedFrames;
+    long long scheduledTicks;
+    long long lateTicks;
+    long long resyncs;
+    double worstLagMs;
+
+    // Frames since the last HUD summary
+    LatencyHistogram windowFrames;
+    uint64_t windowBytes;
+    uint64_t windowWrites;
+
+    bool writeJson(FILE* file) const;
+    bool writeCsv(FILE* file) const;
+};
+
+#endif // SNAKE_STATS_H
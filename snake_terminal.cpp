@@ -0,0 +1,206 @@
+#include "snake_terminal.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void appendCrlf(std::string& out, const char* data, size_t size) {
+    size_t start = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == '\n') {
+            out.append(data + start, i - start);
+            out += "\r\n";
+            start = i + 1;
+        }
+    }
+    out.append(data + start, size - start);
+}
+
+bool KeyDecoder::feed(char c, char& key) {
+    switch (parseState) {
+        case PARSE_GROUND:
+            #ifdef _WIN32
+            if (c == 0 || c == -32) {  // Windows extended key prefix
+                parseState = PARSE_SEQUENCE;
+                return false;
+            }
+            #else
+            if (c == 27) {  // ESC
+                parseState = PARSE_ESCAPE;
+                return false;
+            }
+            #endif
+            key = c;
+            return true;
+
+        case PARSE_ESCAPE:
+            if (c == '[' || c == 'O') {  // CSI or SS3 introducer
+                parseState = PARSE_SEQUENCE;
+                return false;
+            }
+            if (c == 27) return false;
+            // A bare ESC followed by an ordinary key
+            parseState = PARSE_GROUND;
+            key = c;
+            return true;
+
+        case PARSE_SEQUENCE:
+            #ifdef _WIN32
+            parseState = PARSE_GROUND;
+            switch (c) {
+                case 72: key = 'w'; return true; // Up arrow
+                case 80: key = 's'; return true; // Down arrow
+                case 77: key = 'd'; return true; // Right arrow
+                case 75: key = 'a'; return true; // Left arrow
+            }
+            #else
+            if (c < 0x40 || c > 0x7E) return false;  // Parameter bytes
+            parseState = PARSE_GROUND;
+            switch (c) {
+                case 'A': key = 'w'; return true; // Up arrow
+                case 'B': key = 's'; return true; // Down arrow
+                case 'C': key = 'd'; return true; // Right arrow
+                case 'D': key = 'a'; return true; // Left arrow
+            }
+            #endif
+            return false;  // Some other sequence; ignore it
+    }
+    return false;
+}
+
+void TurnQueue::push(Direction d, Direction current) {
+    Direction base = count > 0 ? turns[(head + count - 1) % MAX_QUEUED_TURNS] : current;
+    if (d == base || isOpposite(base, d) || count == MAX_QUEUED_TURNS) {
+        return;
+    }
+    turns[(head + count) % MAX_QUEUED_TURNS] = d;
+    count++;
+}
+
+bool TurnQueue::pop(Direction& d) {
+    if (count == 0) return false;
+    d = turns[head];
+    head = (head + 1) % MAX_QUEUED_TURNS;
+    count--;
+    return true;
+}
+
+BoardFit fitBoard(int columns, int rows) {
+    const int horizontalPadding = 4;  // Two leading spaces plus side walls
+    // Title(3) + Score(1) + Warning(1) + TopBorder(1) + BottomBorder(1) + Controls(1) = 9 lines
+    const int verticalPadding = 9;
+
+    int availableWidth = (columns > 0) ? columns - horizontalPadding : DEFAULT_WIDTH;
+    int availableHeight = (rows > 0) ? rows - verticalPadding : DEFAULT_HEIGHT;
+
+    if (availableWidth <= 0) availableWidth = DEFAULT_WIDTH;
+    if (availableHeight <= 0) availableHeight = DEFAULT_HEIGHT;
+
+    int width = std::min(DEFAULT_WIDTH, availableWidth);
+    int height = std::min(DEFAULT_HEIGHT, availableHeight);
+
+    if (availableWidth < 5) {
+        width = std::max(availableWidth, 1);
+    } else if (width < MIN_WIDTH && availableWidth >= MIN_WIDTH) {
+        width = MIN_WIDTH;
+    }
+
+    if (availableHeight < 5) {
+        height = std::max(availableHeight, 1);
+    } else if (height < MIN_HEIGHT && availableHeight >= MIN_HEIGHT) {
+        height = MIN_HEIGHT;
+    }
+
+    BoardFit fit;
+    fit.width = std::max(width, 1);
+    fit.height = std::max(height, 1);
+    // Never draw more than fits; larger boards scroll with the head
+    fit.viewWidth = std::max(availableWidth, 1);
+    fit.viewHeight = std::max(availableHeight, 1);
+
+    if (fit.width < DEFAULT_WIDTH || fit.height < DEFAULT_HEIGHT) {
+        char warn[96];
+        snprintf(warn, sizeof(warn), "Arena scaled to %dx%d (ideal %dx%d)",
+                 fit.width, fit.height, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        fit.warning = warn;
+
+        int maxHudWidth = fit.width + 4;
+        if (static_cast<int>(fit.warning.size()) > maxHudWidth) {
+            snprintf(warn, sizeof(warn), "Arena %dx%d", fit.width, fit.height);
+            fit.warning = warn;
+        }
+    }
+    return fit;
+}
+
+void appendWelcomeScreen(std::string& out) {
+    out += "\n\n";
+    out += GREEN;
+    out += BOLD;
+    out += "    ███████╗███╗   ██╗ █████╗ ██╗  ██╗███████╗\n";
+    out += "    ██╔════╝████╗  ██║██╔══██╗██║ ██╔╝██╔════╝\n";
+    out += "    ███████╗██╔██╗ ██║███████║█████╔╝ █████╗  \n";
+    out += "    ╚════██║██║╚██╗██║██╔══██║██╔═██╗ ██╔══╝  \n";
+    out += "    ███████║██║ ╚████║██║  ██║██║  ██╗███████╗\n";
+    out += "    ╚══════╝╚═╝  ╚═══╝╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝\n";
+    out += RESET;
+    out += "\n\n";
+
+    out += CYAN;
+    out += "  ╔════════════════════════════════════════╗\n";
+    out += "  ║  ";
+    out += WHITE;
+    out += "Classic Snake Game in C++        ";
+    out += CYAN;
+    out += "     ║\n";
+    out += "  ╚════════════════════════════════════════╝";
+    out += RESET;
+    out += "\n\n";
+
+    out += YELLOW;
+    out += "  How to Play:\n";
+    out += RESET;
+    out += "  • Use " + std::string(GREEN) + "WASD" + RESET + " or " + GREEN + "Arrow Keys" + RESET + " to move\n";
+    out += "  • Eat the " + std::string(RED) + "red food" + RESET + " to grow\n";
+    out += "  • Don't hit walls or yourself!\n";
+    out += "  • Press " + std::string(MAGENTA) + "SPACE" + RESET + " to pause, " + MAGENTA + "B" + RESET + " to rewind\n";
+    out += "  • The game speeds up as you score!\n\n";
+
+    out += BOLD;
+    out += "  Press ENTER to start...";
+    out += RESET;
+}
+
+void appendGameOverScreen(std::string& out, int score, size_t length, bool offerRewind) {
+    out += "\n\n";
+    out += RED;
+    out += BOLD;
+    out += "    ╔═══════════════════════════════════════╗\n";
+    out += "    ║                                       ║\n";
+    out += "    ║               GAME OVER!              ║\n";
+    out += "    ║                                       ║\n";
+    out += "    ╚═══════════════════════════════════════╝\n";
+    out += RESET;
+    out += "\n";
+
+    char line[96];
+    snprintf(line, sizeof(line), "%s    Final Score: %s%d%s\n", YELLOW, BOLD, score, RESET);
+    out += line;
+    snprintf(line, sizeof(line), "%s    Snake Length: %s%zu%s\n\n", MAGENTA, BOLD, length, RESET);
+    out += line;
+
+    if (score >= 50) {
+        out += std::string(GREEN) + BOLD + "    🏆 LEGENDARY! You're a Snake Master! 🏆\n" + RESET;
+    } else if (score >= 30) {
+        out += std::string(CYAN) + BOLD + "    ⭐ AMAZING! Excellent skills! ⭐\n" + RESET;
+    } else if (score >= 15) {
+        out += std::string(BLUE) + BOLD + "    👍 Great job! Keep practicing!\n" + RESET;
+    } else {
+        out += std::string(WHITE) + "    Good try! Practice makes perfect!\n" + RESET;
+    }
+
+    out += "\n    " + std::string(WHITE) + "Press " + GREEN + "R" + WHITE + " to play again";
+    if (offerRewind) {
+        out += ", " + std::string(YELLOW) + "B" + WHITE + " to rewind";
+    }
+    out += " or " + std::string(RED) + "Q" + WHITE + " to quit..." + RESET;
+}
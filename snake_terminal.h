@@ -0,0 +1,118 @@
+// Terminal-side pieces shared by the local frontend and the game server.
+//
+// A game reaches its player through a TerminalOutput (the process's stdout
+// or a socket) and reads keys by feeding raw bytes, from wherever they
+// arrive, to a KeyDecoder. Screens and board sizing are worked out here
+// from a terminal size alone, so every frontend lays out and plays the same.
+// Nothing in this file performs I/O.
+
+#ifndef SNAKE_TERMINAL_H
+#define SNAKE_TERMINAL_H
+
+#include <cstddef>
+#include <string>
+
+#include "snake_engine.h"
+
+// ANSI Color Codes
+const char* const RESET = "\033[0m";
+const char* const RED = "\033[31m";
+const char* const GREEN = "\033[32m";
+const char* const YELLOW = "\033[33m";
+const char* const BLUE = "\033[34m";
+const char* const MAGENTA = "\033[35m";
+const char* const CYAN = "\033[36m";
+const char* const WHITE = "\033[37m";
+const char* const BOLD = "\033[1m";
+
+// Terminal layout constants
+const int MIN_WIDTH = 12;
+const int MIN_HEIGHT = 8;
+const int FALLBACK_COLUMNS = DEFAULT_WIDTH + 4;  // Assumed when the size is unknown
+const int FALLBACK_ROWS = DEFAULT_HEIGHT + 8;
+
+// Input constants
+const int MAX_QUEUED_TURNS = 3;   // direction changes buffered ahead of the snake
+
+// Rewind constants
+const int REWIND_HISTORY_TICKS = 10 * 1000 / 50; // ten seconds at top speed
+const int REWIND_STEP_MS = 2000;  // game time taken back per B press
+
+// Where a game's output goes
+class TerminalOutput {
+public:
+    virtual ~TerminalOutput() {}
+
+    // Send bytes to the terminal, in order after everything written before
+    virtual void write(const char* data, size_t size) = 0;
+
+    void write(const std::string& bytes) { write(bytes.data(), bytes.size()); }
+};
+
+// Append `data` with each "\n" as "\r\n", for clients reached without a
+// tty to do it (sockets)
+void appendCrlf(std::string& out, const char* data, size_t size);
+
+// Turns raw terminal bytes into key presses, with arrow keys translated to
+// WASD. Escape sequences split across reads are held until the rest arrives.
+class KeyDecoder {
+public:
+    KeyDecoder() : parseState(PARSE_GROUND) {}
+
+    // Take one byte; true with `key` set when it completes a key press
+    bool feed(char c, char& key);
+
+    // Drop any half-parsed sequence
+    void reset() { parseState = PARSE_GROUND; }
+
+private:
+    enum ParseState {
+        PARSE_GROUND,
+        PARSE_ESCAPE,   // Saw ESC, waiting for '[' or 'O'
+        PARSE_SEQUENCE  // Inside an escape (or Windows extended key) sequence
+    };
+
+    ParseState parseState;
+};
+
+// Turns queued ahead of the snake, one applied per tick, so quick double
+// turns are not lost. Turns that repeat or reverse the direction the snake
+// will have by then are dropped, as are turns beyond MAX_QUEUED_TURNS.
+class TurnQueue {
+public:
+    TurnQueue() : head(0), count(0) {}
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Queue `d` after any pending turns; `current` is the snake's direction now
+    void push(Direction d, Direction current);
+
+    // Take the oldest pending turn; false if there is none
+    bool pop(Direction& d);
+
+private:
+    Direction turns[MAX_QUEUED_TURNS];  // Ring of pending turns
+    int head;
+    int count;
+};
+
+// Board and viewport for a terminal of a given size
+struct BoardFit {
+    int width;           // Board to play on: the default size, shrunk to fit
+    int height;
+    int viewWidth;       // Most board cells that fit on screen
+    int viewHeight;
+    std::string warning; // Set when the board had to shrink
+};
+
+// Fit the board to a columns x rows terminal (0 or less if unknown)
+BoardFit fitBoard(int columns, int rows);
+
+// Welcome and game over screens, for a cleared screen with the cursor home
+void appendWelcomeScreen(std::string& out);
+void appendGameOverScreen(std::string& out, int score, size_t length, bool offerRewind);
+
+#endif // SNAKE_TERMINAL_H